@@ -1,4 +1,6 @@
 #include "proclib.hpp"
+#include <algorithm>
+#include <cmath>
 
 /**
  * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
@@ -19,6 +21,90 @@ namespace
         return gray;
     }
 
+    /**
+     * @brief Гистограмма яркостей прямоугольной области изображения.
+     * Счет ведется в четыре частичные гистограммы, чтобы серии одинаковых
+     * пикселей не упирались в инкремент одной и той же ячейки.
+     */
+    void regionHistogram(const cv::Mat& gray, const cv::Rect& roi, long histogram[256])
+    {
+        long partial[4][256] = {{0}};
+        for (int y = roi.y; y < roi.y + roi.height; y++) {
+            const uchar* rowPtr = gray.ptr<uchar>(y) + roi.x;
+            int x = 0;
+            for (; x + 4 <= roi.width; x += 4) {
+                partial[0][rowPtr[x]]++;
+                partial[1][rowPtr[x + 1]]++;
+                partial[2][rowPtr[x + 2]]++;
+                partial[3][rowPtr[x + 3]]++;
+            }
+            for (; x < roi.width; x++) {
+                partial[0][rowPtr[x]]++;
+            }
+        }
+        for (int i = 0; i < 256; i++) {
+            histogram[i] = partial[0][i] + partial[1][i] + partial[2][i] + partial[3][i];
+        }
+    }
+
+    /**
+     * @brief Гистограмма всего изображения; полосы строк считаются параллельно.
+     */
+    void imageHistogram(const cv::Mat& gray, long histogram[256])
+    {
+        int stripeCount = std::max(1, std::min(cv::getNumThreads() * 2, gray.rows / 64));
+        std::vector<std::vector<long>> partial(stripeCount, std::vector<long>(256));
+
+        cv::parallel_for_(cv::Range(0, stripeCount), [&](const cv::Range& range) {
+            for (int s = range.start; s < range.end; s++) {
+                int y0 = (int)((int64_t)gray.rows * s / stripeCount);
+                int y1 = (int)((int64_t)gray.rows * (s + 1) / stripeCount);
+                regionHistogram(gray, cv::Rect(0, y0, gray.cols, y1 - y0), partial[s].data());
+            }
+        });
+
+        for (int i = 0; i < 256; i++) {
+            histogram[i] = 0;
+            for (int s = 0; s < stripeCount; s++) histogram[i] += partial[s][i];
+        }
+    }
+
+    /**
+     * @brief Таблица выравнивания по гистограмме области из total пикселей.
+     */
+    void equalizationLut(const long histogram[256], long total, uchar lut[256])
+    {
+        long cdf = 0;
+        for (int i = 0; i < 256; i++) {
+            cdf += histogram[i];
+            lut[i] = total > 0 ? (uchar)((cdf * 255 + total / 2) / total) : (uchar)i;
+        }
+    }
+
+    /**
+     * @brief Ограничивает столбцы гистограммы значением limit и равномерно
+     * перераспределяет срезанный избыток (шаг CLAHE).
+     */
+    void clipHistogram(long histogram[256], long limit)
+    {
+        long excess = 0;
+        for (int i = 0; i < 256; i++) {
+            if (histogram[i] > limit) {
+                excess += histogram[i] - limit;
+                histogram[i] = limit;
+            }
+        }
+        if (excess == 0) return;
+
+        long perBin = excess / 256;
+        long residual = excess % 256;
+        for (int i = 0; i < 256; i++) histogram[i] += perBin;
+        if (residual > 0) {
+            long step = std::max(256L / residual, 1L);
+            for (int i = 0; i < 256 && residual > 0; i += step, residual--) histogram[i]++;
+        }
+    }
+
     /**
      * @brief Рассчитывает оптимальный порог по методу Оцу.
      */
@@ -29,13 +115,8 @@ namespace
         long totalPixels = graySrc.rows * graySrc.cols;
         if (totalPixels == 0) return -1;
 
-        long histogram[256] = {0};
-        for (int y = 0; y < graySrc.rows; y++) {
-            const uchar* rowPtr = graySrc.ptr<uchar>(y);
-            for (int x = 0; x < graySrc.cols; x++) {
-                histogram[rowPtr[x]]++;
-            }
-        }
+        long histogram[256];
+        imageHistogram(graySrc, histogram);
 
         long totalSum = 0;
         for (int i = 0; i < 256; i++) {
@@ -69,6 +150,582 @@ namespace
         
         return bestThreshold;
     }
+
+    /**
+     * @brief Количество младших нулевых битов (v != 0).
+     */
+    inline int countTrailingZeros(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(v);
+#else
+        int n = 0;
+        while (!(v & 1u)) { v >>= 1; n++; }
+        return n;
+#endif
+    }
+
+    /**
+     * @brief Упаковывает пиксели gray > threshold в биты (параллельно по строкам).
+     */
+    proc::BitImage packAbove(const cv::Mat& gray, int threshold)
+    {
+        CV_Assert(gray.channels() == 1 && gray.type() == CV_8U);
+        proc::BitImage bits(gray.rows, gray.cols);
+
+        cv::parallel_for_(cv::Range(0, gray.rows), [&](const cv::Range& range) {
+            for (int y = range.start; y < range.end; y++) {
+                const uchar* src = gray.ptr<uchar>(y);
+                uint64_t* dst = bits.row(y);
+                for (int w = 0; w < bits.wordsPerRow; w++) {
+                    int base = w * 64;
+                    int n = std::min(64, gray.cols - base);
+                    uint64_t v = 0;
+                    for (int b = 0; b < n; b++) {
+                        v |= (uint64_t)(src[base + b] > threshold) << b;
+                    }
+                    dst[w] = v;
+                }
+            }
+        });
+        return bits;
+    }
+
+    /**
+     * @brief Горизонтальная серия пикселей объекта [x0, x1] с временной меткой.
+     */
+    struct Run
+    {
+        int x0;
+        int x1;
+        int label;
+    };
+
+    /**
+     * @brief Источник серий для байтового бинарного изображения.
+     */
+    struct ByteRunSource
+    {
+        const cv::Mat& image;
+
+        int rows() const { return image.rows; }
+        int cols() const { return image.cols; }
+
+        void runs(int y, std::vector<Run>& out) const
+        {
+            out.clear();
+            const uchar* p = image.ptr<uchar>(y);
+            int x = 0;
+            while (x < image.cols) {
+                while (x < image.cols && !p[x]) x++;
+                if (x == image.cols) break;
+                int start = x;
+                while (x < image.cols && p[x]) x++;
+                out.push_back({start, x - 1, 0});
+            }
+        }
+    };
+
+    /**
+     * @brief Источник серий для упакованного изображения: границы серий ищутся
+     * по словам через подсчет нулевых битов, а не попиксельно.
+     */
+    struct BitRunSource
+    {
+        const proc::BitImage& image;
+
+        int rows() const { return image.rows; }
+        int cols() const { return image.cols; }
+
+        void runs(int y, std::vector<Run>& out) const
+        {
+            out.clear();
+            const uint64_t* words = image.row(y);
+            int open = -1;
+            for (int w = 0; w < image.wordsPerRow; w++) {
+                uint64_t v = words[w];
+                int base = w * 64;
+                int bit = 0;
+                while (bit < 64) {
+                    uint64_t m = (open < 0) ? (v >> bit) : (~v >> bit);
+                    if (!m) break;
+                    bit += countTrailingZeros(m);
+                    if (open < 0) {
+                        open = base + bit;
+                    } else {
+                        out.push_back({open, base + bit - 1, 0});
+                        open = -1;
+                    }
+                }
+            }
+            if (open >= 0) out.push_back({open, image.cols - 1, 0});
+        }
+    };
+
+    /**
+     * @brief Накопитель статистики компоненты (суммы координат для центра масс).
+     */
+    struct StatsAccumulator
+    {
+        int64_t area = 0;
+        int64_t sumX = 0;
+        int64_t sumY = 0;
+        int left = INT32_MAX, top = INT32_MAX;
+        int right = -1, bottom = -1;
+
+        void addRun(int x0, int x1, int y)
+        {
+            int64_t len = x1 - x0 + 1;
+            area += len;
+            sumX += (int64_t)(x0 + x1) * len / 2;
+            sumY += (int64_t)y * len;
+            left = std::min(left, x0);
+            right = std::max(right, x1);
+            top = std::min(top, y);
+            bottom = std::max(bottom, y);
+        }
+
+        void merge(const StatsAccumulator& o)
+        {
+            area += o.area;
+            sumX += o.sumX;
+            sumY += o.sumY;
+            left = std::min(left, o.left);
+            right = std::max(right, o.right);
+            top = std::min(top, o.top);
+            bottom = std::max(bottom, o.bottom);
+        }
+    };
+
+    /**
+     * @brief Система непересекающихся множеств; корнем всегда остается меньший индекс.
+     */
+    struct UnionFind
+    {
+        std::vector<int> parent;
+
+        int add()
+        {
+            parent.push_back((int)parent.size());
+            return (int)parent.size() - 1;
+        }
+
+        int find(int i)
+        {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        }
+
+        int unite(int a, int b)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b) return a;
+            if (a > b) std::swap(a, b);
+            parent[b] = a;
+            return a;
+        }
+    };
+
+    /**
+     * @brief Результат разметки одной полосы строк.
+     */
+    struct Stripe
+    {
+        int rowBegin = 0;
+        int rowEnd = 0;
+        UnionFind uf;                       ///< Временные метки полосы.
+        std::vector<StatsAccumulator> acc;  ///< Статистика по временным меткам.
+        std::vector<int> compact;           ///< Временная метка -> локальный номер.
+        std::vector<StatsAccumulator> local;///< Статистика по локальным номерам.
+        std::vector<int> finalLabel;        ///< Временная метка -> итоговая метка.
+    };
+
+    /**
+     * @brief Проверяет, касаются ли серии соседних строк при заданной связности.
+     */
+    inline bool runsTouch(const Run& upper, const Run& lower, int reach)
+    {
+        return upper.x1 >= lower.x0 - reach && upper.x0 <= lower.x1 + reach;
+    }
+
+    /**
+     * @brief Размечает полосу: в изображение меток пишутся временные метки + 1.
+     */
+    template <typename Source>
+    void labelStripe(const Source& src, int reach, Stripe& stripe, cv::Mat& labels)
+    {
+        std::vector<Run> prev, cur;
+
+        for (int y = stripe.rowBegin; y < stripe.rowEnd; y++) {
+            src.runs(y, cur);
+            int* out = labels.ptr<int>(y);
+            size_t j = 0;
+
+            for (Run& run : cur) {
+                while (j < prev.size() && prev[j].x1 < run.x0 - reach) j++;
+
+                int label = -1;
+                for (size_t k = j; k < prev.size() && prev[k].x0 <= run.x1 + reach; k++) {
+                    label = (label < 0) ? stripe.uf.find(prev[k].label)
+                                        : stripe.uf.unite(label, prev[k].label);
+                }
+                if (label < 0) {
+                    label = stripe.uf.add();
+                    stripe.acc.emplace_back();
+                }
+
+                run.label = label;
+                stripe.acc[label].addRun(run.x0, run.x1, y);
+                std::fill(out + run.x0, out + run.x1 + 1, label + 1);
+            }
+            std::swap(prev, cur);
+        }
+
+        // Сжимаем временные метки полосы в локальные номера 0..k-1
+        int count = (int)stripe.uf.parent.size();
+        stripe.compact.assign(count, -1);
+        for (int p = 0; p < count; p++) {
+            int root = stripe.uf.find(p);
+            if (root == p) {
+                stripe.compact[p] = (int)stripe.local.size();
+                stripe.local.push_back(stripe.acc[p]);
+            } else {
+                stripe.compact[p] = stripe.compact[root];
+                stripe.local[stripe.compact[p]].merge(stripe.acc[p]);
+            }
+        }
+        stripe.acc.clear();
+        stripe.acc.shrink_to_fit();
+    }
+
+    template <typename Source>
+    proc::LabelingResult labelComponentsImpl(const Source& src, int connectivity)
+    {
+        CV_Assert(connectivity == 4 || connectivity == 8);
+        const int reach = (connectivity == 8) ? 1 : 0;
+        const int rows = src.rows();
+        const int cols = src.cols();
+
+        proc::LabelingResult result;
+        result.labels = cv::Mat::zeros(rows, cols, CV_32S);
+        if (rows == 0 || cols == 0) return result;
+
+        // Не меньше 16 строк на полосу, иначе склейка границ дороже самой разметки
+        int stripeCount = std::max(1, std::min(cv::getNumThreads() * 4, rows / 16));
+        std::vector<Stripe> stripes(stripeCount);
+        for (int s = 0; s < stripeCount; s++) {
+            stripes[s].rowBegin = (int)((int64_t)rows * s / stripeCount);
+            stripes[s].rowEnd = (int)((int64_t)rows * (s + 1) / stripeCount);
+        }
+
+        cv::parallel_for_(cv::Range(0, stripeCount), [&](const cv::Range& range) {
+            for (int s = range.start; s < range.end; s++) {
+                labelStripe(src, reach, stripes[s], result.labels);
+            }
+        });
+
+        // Глобальные номера: смещение полосы + локальный номер
+        std::vector<int> offset(stripeCount + 1, 0);
+        for (int s = 0; s < stripeCount; s++) {
+            offset[s + 1] = offset[s] + (int)stripes[s].local.size();
+        }
+        UnionFind global;
+        global.parent.resize(offset[stripeCount]);
+        for (int i = 0; i < offset[stripeCount]; i++) global.parent[i] = i;
+
+        auto globalId = [&](int s, int y, int x) {
+            int provisional = result.labels.ptr<int>(y)[x] - 1;
+            return offset[s] + stripes[s].compact[provisional];
+        };
+
+        // Склейка по границам полос: читаются только две строки на границу
+        std::vector<Run> upper, lower;
+        for (int s = 1; s < stripeCount; s++) {
+            int yLower = stripes[s].rowBegin;
+            int yUpper = yLower - 1;
+            src.runs(yUpper, upper);
+            src.runs(yLower, lower);
+
+            size_t j = 0;
+            for (const Run& run : lower) {
+                while (j < upper.size() && upper[j].x1 < run.x0 - reach) j++;
+                for (size_t k = j; k < upper.size() && runsTouch(upper[k], run, reach); k++) {
+                    global.unite(globalId(s - 1, yUpper, upper[k].x0), globalId(s, yLower, run.x0));
+                }
+            }
+        }
+
+        // Итоговые метки 1..N и объединенная статистика
+        std::vector<int> finalOf(offset[stripeCount]);
+        std::vector<StatsAccumulator> merged;
+        for (int s = 0; s < stripeCount; s++) {
+            for (int i = 0; i < (int)stripes[s].local.size(); i++) {
+                int g = offset[s] + i;
+                int root = global.find(g);
+                if (root == g) {
+                    finalOf[g] = (int)merged.size() + 1;
+                    merged.push_back(stripes[s].local[i]);
+                } else {
+                    finalOf[g] = finalOf[root];
+                    merged[finalOf[g] - 1].merge(stripes[s].local[i]);
+                }
+            }
+            Stripe& stripe = stripes[s];
+            stripe.finalLabel.resize(stripe.compact.size());
+            for (size_t p = 0; p < stripe.compact.size(); p++) {
+                stripe.finalLabel[p] = finalOf[offset[s] + stripe.compact[p]];
+            }
+        }
+
+        // Перезапись временных меток итоговыми (читается только изображение меток)
+        cv::parallel_for_(cv::Range(0, stripeCount), [&](const cv::Range& range) {
+            for (int s = range.start; s < range.end; s++) {
+                const std::vector<int>& map = stripes[s].finalLabel;
+                for (int y = stripes[s].rowBegin; y < stripes[s].rowEnd; y++) {
+                    int* row = result.labels.ptr<int>(y);
+                    for (int x = 0; x < cols; x++) {
+                        if (row[x]) row[x] = map[row[x] - 1];
+                    }
+                }
+            }
+        });
+
+        result.components.resize(merged.size());
+        for (size_t i = 0; i < merged.size(); i++) {
+            const StatsAccumulator& a = merged[i];
+            proc::ComponentStats& c = result.components[i];
+            c.label = (int)i + 1;
+            c.area = a.area;
+            c.left = a.left;
+            c.top = a.top;
+            c.right = a.right;
+            c.bottom = a.bottom;
+            c.cx = (double)a.sumX / a.area;
+            c.cy = (double)a.sumY / a.area;
+        }
+        return result;
+    }
+    /**
+     * @brief Устанавливает биты [x0, x1] строки целыми словами.
+     */
+    void setBitRange(uint64_t* row, int x0, int x1)
+    {
+        int w0 = x0 >> 6;
+        int w1 = x1 >> 6;
+        uint64_t first = ~0ULL << (x0 & 63);
+        uint64_t last = ~0ULL >> (63 - (x1 & 63));
+        if (w0 == w1) {
+            row[w0] |= first & last;
+            return;
+        }
+        row[w0] |= first;
+        for (int w = w0 + 1; w < w1; w++) row[w] = ~0ULL;
+        row[w1] |= last;
+    }
+
+    /**
+     * @brief Инвертирует упакованное изображение, сохраняя нулевые биты за краем строки.
+     */
+    void complementInPlace(proc::BitImage& img)
+    {
+        const uint64_t tailMask = (img.cols % 64) ? ((1ULL << (img.cols % 64)) - 1) : ~0ULL;
+
+        cv::parallel_for_(cv::Range(0, img.rows), [&](const cv::Range& range) {
+            for (int y = range.start; y < range.end; y++) {
+                uint64_t* row = img.row(y);
+                for (int w = 0; w < img.wordsPerRow; w++) row[w] = ~row[w];
+                if (img.wordsPerRow > 0) row[img.wordsPerRow - 1] &= tailMask;
+            }
+        });
+    }
+
+    /**
+     * @brief Горизонтальный максимум по окну [x - before, x + after].
+     * Каждая серия единиц расширяется целиком и заполняется словами; уже
+     * заполненная часть строки повторно не пишется, поэтому стоимость
+     * определяется числом серий и слов, а не шириной окна.
+     */
+    proc::BitImage dilateRows(const proc::BitImage& src, int before, int after)
+    {
+        proc::BitImage dst(src.rows, src.cols);
+        if (before == 0 && after == 0) {
+            dst.words = src.words;
+            return dst;
+        }
+        BitRunSource source{src};
+
+        cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& range) {
+            std::vector<Run> runs;
+            for (int y = range.start; y < range.end; y++) {
+                source.runs(y, runs);
+                uint64_t* out = dst.row(y);
+                int filled = -1;
+                for (const Run& run : runs) {
+                    int x0 = std::max(run.x0 - after, filled + 1);
+                    int x1 = std::min(run.x1 + before, src.cols - 1);
+                    if (x0 <= x1) {
+                        setBitRange(out, x0, x1);
+                        filled = x1;
+                    }
+                }
+            }
+        });
+        return dst;
+    }
+
+    /**
+     * @brief Вертикальный максимум по окну [y - before, y + after] методом
+     * ван Херка / Гиля-Вермана: столбец слов делится на блоки высотой окна,
+     * внутри блоков считаются префиксные и суффиксные OR, и каждый результат -
+     * это OR одного суффикса и одного префикса, независимо от высоты окна.
+     * Обрабатывается по 64 пикселя на операцию, группы столбцов - параллельно.
+     */
+    proc::BitImage dilateColumns(const proc::BitImage& src, int before, int after)
+    {
+        const int k = before + after + 1;
+        proc::BitImage dst(src.rows, src.cols);
+        if (k == 1) {
+            dst.words = src.words;
+            return dst;
+        }
+
+        const int chunk = 8; // одна линия кэша слов
+        const int chunks = (src.wordsPerRow + chunk - 1) / chunk;
+        const int padded = src.rows + k - 1;
+
+        cv::parallel_for_(cv::Range(0, chunks), [&](const cv::Range& range) {
+            std::vector<uint64_t> prefix((size_t)padded * chunk);
+            std::vector<uint64_t> suffix((size_t)padded * chunk);
+
+            for (int c = range.start; c < range.end; c++) {
+                const int w0 = c * chunk;
+                const int cw = std::min(chunk, src.wordsPerRow - w0);
+                // Строка i дополненного столбца - это строка i - before исходного (вне - нули)
+                auto input = [&](int i, int j) -> uint64_t {
+                    int y = i - before;
+                    return (y >= 0 && y < src.rows) ? src.row(y)[w0 + j] : 0;
+                };
+
+                for (int i = 0; i < padded; i++) {
+                    uint64_t* g = &prefix[(size_t)i * chunk];
+                    bool blockStart = (i % k == 0);
+                    for (int j = 0; j < cw; j++) {
+                        g[j] = blockStart ? input(i, j) : (g[j - chunk] | input(i, j));
+                    }
+                }
+                for (int i = padded - 1; i >= 0; i--) {
+                    uint64_t* h = &suffix[(size_t)i * chunk];
+                    bool blockEnd = (i % k == k - 1) || (i == padded - 1);
+                    for (int j = 0; j < cw; j++) {
+                        h[j] = blockEnd ? input(i, j) : (h[j + chunk] | input(i, j));
+                    }
+                }
+                for (int y = 0; y < src.rows; y++) {
+                    const uint64_t* h = &suffix[(size_t)y * chunk];
+                    const uint64_t* g = &prefix[(size_t)(y + k - 1) * chunk];
+                    uint64_t* out = dst.row(y) + w0;
+                    for (int j = 0; j < cw; j++) out[j] = h[j] | g[j];
+                }
+            }
+        });
+        return dst;
+    }
+
+    /**
+     * @brief Дилатация прямоугольником kernelWidth x kernelHeight с якорем в центре.
+     */
+    proc::BitImage dilateRect(const proc::BitImage& src, int kernelWidth, int kernelHeight)
+    {
+        proc::BitImage rows = dilateRows(src, kernelWidth / 2, kernelWidth - 1 - kernelWidth / 2);
+        return dilateColumns(rows, kernelHeight / 2, kernelHeight - 1 - kernelHeight / 2);
+    }
+
+    /**
+     * @brief Эрозия как дополнение дилатации дополнения: пиксели за краем
+     * изображения считаются единичными и не разъедают объект.
+     */
+    proc::BitImage erodeRect(const proc::BitImage& src, int kernelWidth, int kernelHeight)
+    {
+        proc::BitImage inverted = src;
+        complementInPlace(inverted);
+        proc::BitImage result = dilateRect(inverted, kernelWidth, kernelHeight);
+        complementInPlace(result);
+        return result;
+    }
+
+    /**
+     * @brief Полуширины трех прямоугольных окон, свертка которых по дисперсии ближе
+     * всего к гауссиане sigma (схема Уэллса): окна нечетной ширины wl и wl + 2.
+     */
+    void boxRadiiForGauss(double sigma, int radii[3])
+    {
+        const int n = 3;
+        int wl = (int)std::floor(std::sqrt(12 * sigma * sigma / n + 1));
+        if (wl % 2 == 0) wl--;
+        int m = (int)std::lround((12 * sigma * sigma - n * wl * wl - 4.0 * n * wl - 3 * n) / (-4.0 * wl - 4));
+        for (int i = 0; i < n; i++) radii[i] = ((i < m ? wl : wl + 2) - 1) / 2;
+    }
+
+    /**
+     * @brief Скользящее среднее строки из cols пикселей по cn каналов по окну
+     * [x - r, x + r] с повтором краевых пикселей. Сумма окна обновляется одним
+     * прибавлением и одним вычитанием, так что стоимость пикселя не зависит от r.
+     * Результат - яркость с 8 дробными битами: scale = 256 / (2r + 1) для 8-битного
+     * входа и 1 / (2r + 1) для входа, уже в этом формате.
+     */
+    template <typename T>
+    void boxBlurRow(const T* src, uint16_t* dst, int cols, int cn, int r, float scale)
+    {
+        for (int c = 0; c < cn; c++) {
+            const T* s = src + c;
+            uint16_t* d = dst + c;
+            int sum = (r + 1) * s[0];
+            for (int i = 1; i <= r; i++) sum += s[std::min(i, cols - 1) * cn];
+            // Края повторяются только у концов строки; в середине окно целиком внутри
+            const int mid0 = std::min(r, cols);
+            const int mid1 = std::max(mid0, cols - r - 1);
+            int x = 0;
+            for (; x < mid0; x++) {
+                d[x * cn] = (uint16_t)(sum * scale + 0.5f);
+                sum += s[std::min(x + r + 1, cols - 1) * cn] - s[0];
+            }
+            for (; x < mid1; x++) {
+                d[x * cn] = (uint16_t)(sum * scale + 0.5f);
+                sum += s[(x + r + 1) * cn] - s[(x - r) * cn];
+            }
+            for (; x < cols; x++) {
+                d[x * cn] = (uint16_t)(sum * scale + 0.5f);
+                sum += s[(cols - 1) * cn] - s[std::max(x - r, 0) * cn];
+            }
+        }
+    }
+
+    /**
+     * @brief Скользящее среднее по столбцам [x0, x0 + width) изображения CV_16U:
+     * полоса проходится сверху вниз, суммы окон всех ее столбцов лежат в sums
+     * и обновляются строкой целиком (прибавить входящую строку, вычесть уходящую).
+     * emit(y, sums) получает суммы строки y, еще не деленные на 2r + 1.
+     */
+    template <typename Emit>
+    void boxBlurColumns(const cv::Mat& src, int x0, int width, int r, std::vector<int>& sums, Emit emit)
+    {
+        const int rows = src.rows;
+        sums.assign(width, 0);
+        for (int i = -r; i <= r; i++) {
+            const uint16_t* s = src.ptr<uint16_t>(std::max(0, std::min(i, rows - 1))) + x0;
+            for (int j = 0; j < width; j++) sums[j] += s[j];
+        }
+        for (int y = 0; y < rows; y++) {
+            emit(y, sums.data());
+            const uint16_t* in = src.ptr<uint16_t>(std::min(y + r + 1, rows - 1)) + x0;
+            const uint16_t* out = src.ptr<uint16_t>(std::max(y - r, 0)) + x0;
+            for (int j = 0; j < width; j++) sums[j] += in[j] - out[j];
+        }
+    }
 } // namespace
 
 
@@ -86,6 +743,67 @@ cv::Mat proc::sharpen(const cv::Mat& src)
     return dest;
 }
 
+cv::Mat proc::unsharpMask(const cv::Mat& src, double radius, double amount, int threshold)
+{
+    cv::Mat image = src;
+    if (image.depth() != CV_8U) src.convertTo(image, CV_8U);
+    if (image.empty() || !(radius > 0)) return image.clone();
+
+    const int rows = image.rows;
+    const int cn = image.channels();
+    const int elems = image.cols * cn;
+    int radii[3];
+    boxRadiiForGauss(radius, radii);
+
+    // 1. Три горизонтальных прохода: строки независимы и размываются параллельно
+    cv::Mat blurA(rows, image.cols, CV_MAKETYPE(CV_16U, cn));
+    cv::Mat blurB(rows, image.cols, CV_MAKETYPE(CV_16U, cn));
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        std::vector<uint16_t> t0(elems), t1(elems);
+        for (int y = range.start; y < range.end; y++) {
+            boxBlurRow(image.ptr<uchar>(y), t0.data(), image.cols, cn, radii[0], 256.0f / (2 * radii[0] + 1));
+            boxBlurRow(t0.data(), t1.data(), image.cols, cn, radii[1], 1.0f / (2 * radii[1] + 1));
+            boxBlurRow(t1.data(), blurA.ptr<uint16_t>(y), image.cols, cn, radii[2], 1.0f / (2 * radii[2] + 1));
+        }
+    });
+
+    // 2. Три вертикальных прохода по полосам столбцов; последний сразу смешивает
+    //    размытие с исходником: d = s + amount * (s - blur), если |s - blur| >= threshold
+    cv::Mat dest(rows, image.cols, image.type());
+    const int strip = 2048; // элементов строки в полосе: суммы полосы помещаются в L1
+    const int strips = (elems + strip - 1) / strip;
+    const float k = (float)amount / 256;
+    const float limit = (float)threshold * 256;
+    cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+        std::vector<int> sums;
+        for (int sIdx = range.start; sIdx < range.end; sIdx++) {
+            const int x0 = sIdx * strip;
+            const int width = std::min(strip, elems - x0);
+
+            for (int pass = 0; pass < 2; pass++) {
+                const cv::Mat& in = (pass == 0) ? blurA : blurB;
+                cv::Mat& out = (pass == 0) ? blurB : blurA;
+                const float scale = 1.0f / (2 * radii[pass] + 1);
+                boxBlurColumns(in, x0, width, radii[pass], sums, [&](int y, const int* sum) {
+                    uint16_t* d = out.ptr<uint16_t>(y) + x0;
+                    for (int j = 0; j < width; j++) d[j] = (uint16_t)(sum[j] * scale + 0.5f);
+                });
+            }
+
+            const float scale = 1.0f / (2 * radii[2] + 1);
+            boxBlurColumns(blurA, x0, width, radii[2], sums, [&](int y, const int* sum) {
+                const uchar* s = image.ptr<uchar>(y) + x0;
+                uchar* d = dest.ptr<uchar>(y) + x0;
+                for (int j = 0; j < width; j++) {
+                    float diff = s[j] * 256.0f - sum[j] * scale;
+                    d[j] = (std::abs(diff) < limit) ? s[j] : cv::saturate_cast<uchar>(s[j] + k * diff);
+                }
+            });
+        }
+    });
+    return dest;
+}
+
 cv::Mat proc::manualThreshold(const cv::Mat& src, int threshold)
 {
     cv::Mat gray = toGrayscale(src);
@@ -109,3 +827,200 @@ cv::Mat proc::otsuThreshold(const cv::Mat& src)
 
     return dest;
 }
+
+
+cv::Mat proc::equalizeHistogram(const cv::Mat& src)
+{
+    cv::Mat gray = toGrayscale(src);
+    cv::Mat dest(gray.rows, gray.cols, CV_8U);
+
+    long histogram[256];
+    imageHistogram(gray, histogram);
+    uchar lut[256];
+    equalizationLut(histogram, (long)gray.rows * gray.cols, lut);
+
+    cv::parallel_for_(cv::Range(0, gray.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const uchar* s = gray.ptr<uchar>(y);
+            uchar* d = dest.ptr<uchar>(y);
+            for (int x = 0; x < gray.cols; x++) d[x] = lut[s[x]];
+        }
+    });
+    return dest;
+}
+
+cv::Mat proc::clahe(const cv::Mat& src, double clipLimit, int tilesX, int tilesY)
+{
+    cv::Mat gray = toGrayscale(src);
+    const int rows = gray.rows;
+    const int cols = gray.cols;
+    cv::Mat dest(rows, cols, CV_8U);
+    if (rows == 0 || cols == 0) return dest;
+
+    tilesX = std::max(1, std::min(tilesX, cols));
+    tilesY = std::max(1, std::min(tilesY, rows));
+    const int tileCount = tilesX * tilesY;
+
+    // 1. Гистограммы, срезание и таблицы - независимо для каждой плитки
+    std::vector<uchar> luts((size_t)tileCount * 256);
+    cv::parallel_for_(cv::Range(0, tileCount), [&](const cv::Range& range) {
+        for (int t = range.start; t < range.end; t++) {
+            int tx = t % tilesX, ty = t / tilesX;
+            int x0 = (int)((int64_t)cols * tx / tilesX), x1 = (int)((int64_t)cols * (tx + 1) / tilesX);
+            int y0 = (int)((int64_t)rows * ty / tilesY), y1 = (int)((int64_t)rows * (ty + 1) / tilesY);
+            long area = (long)(x1 - x0) * (y1 - y0);
+
+            long histogram[256];
+            regionHistogram(gray, cv::Rect(x0, y0, x1 - x0, y1 - y0), histogram);
+            if (clipLimit > 0) {
+                clipHistogram(histogram, std::max(1L, (long)(clipLimit * area / 256)));
+            }
+            equalizationLut(histogram, area, &luts[(size_t)t * 256]);
+        }
+    });
+
+    // 2. Горизонтальные соседи и веса (8 бит) для каждого столбца - один раз на изображение
+    const double tileW = (double)cols / tilesX;
+    const double tileH = (double)rows / tilesY;
+    std::vector<int> colLut0(cols), colLut1(cols), colWeight(cols);
+    for (int x = 0; x < cols; x++) {
+        double fx = (x + 0.5) / tileW - 0.5;
+        int t0 = (int)std::floor(fx);
+        int w = (int)std::lround((fx - t0) * 256);
+        colLut0[x] = std::max(0, std::min(t0, tilesX - 1)) * 256;
+        colLut1[x] = std::max(0, std::min(t0 + 1, tilesX - 1)) * 256;
+        colWeight[x] = (t0 < 0 || t0 >= tilesX - 1) ? 0 : w;
+    }
+
+    // 3. Разделимая интерполяция: для строки таблицы плиток смешиваются по вертикали
+    //    (256 * tilesX операций на строку), затем каждый пиксель - одно смешивание
+    //    двух соседних столбцов таблиц.
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        std::vector<int> rowLut((size_t)tilesX * 256);
+        for (int y = range.start; y < range.end; y++) {
+            double fy = (y + 0.5) / tileH - 0.5;
+            int t0 = (int)std::floor(fy);
+            int wy = (t0 < 0 || t0 >= tilesY - 1) ? 0 : (int)std::lround((fy - t0) * 256);
+            int ty0 = std::max(0, std::min(t0, tilesY - 1));
+            int ty1 = std::max(0, std::min(t0 + 1, tilesY - 1));
+
+            for (int tx = 0; tx < tilesX; tx++) {
+                const uchar* a = &luts[((size_t)ty0 * tilesX + tx) * 256];
+                const uchar* b = &luts[((size_t)ty1 * tilesX + tx) * 256];
+                int* r = &rowLut[(size_t)tx * 256];
+                for (int v = 0; v < 256; v++) {
+                    r[v] = a[v] * (256 - wy) + b[v] * wy;
+                }
+            }
+
+            const uchar* s = gray.ptr<uchar>(y);
+            uchar* d = dest.ptr<uchar>(y);
+            for (int x = 0; x < cols; x++) {
+                int v = s[x];
+                int wx = colWeight[x];
+                int left = rowLut[colLut0[x] + v];
+                int right = rowLut[colLut1[x] + v];
+                d[x] = (uchar)((left * (256 - wx) + right * wx + (1 << 15)) >> 16);
+            }
+        }
+    });
+    return dest;
+}
+
+proc::BitImage::BitImage(int rows, int cols)
+    : rows(rows), cols(cols), wordsPerRow((cols + 63) / 64),
+      words((size_t)rows * ((cols + 63) / 64), 0)
+{
+}
+
+proc::BitImage proc::packBinary(const cv::Mat& binary)
+{
+    return packAbove(binary, 0);
+}
+
+cv::Mat proc::unpackBinary(const BitImage& bits)
+{
+    cv::Mat dest(bits.rows, bits.cols, CV_8U);
+
+    cv::parallel_for_(cv::Range(0, bits.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const uint64_t* src = bits.row(y);
+            uchar* dst = dest.ptr<uchar>(y);
+            for (int x = 0; x < bits.cols; x++) {
+                dst[x] = ((src[x >> 6] >> (x & 63)) & 1u) ? 255 : 0;
+            }
+        }
+    });
+    return dest;
+}
+
+proc::BitImage proc::manualThresholdPacked(const cv::Mat& src, int threshold)
+{
+    return packAbove(toGrayscale(src), threshold);
+}
+
+proc::BitImage proc::otsuThresholdPacked(const cv::Mat& src)
+{
+    cv::Mat gray = toGrayscale(src);
+
+    int otsuT = calculateOtsuThresholdInternal(gray);
+
+    std::cout << "Otsu method calculated threshold: " << otsuT << std::endl;
+
+    return packAbove(gray, otsuT);
+}
+
+proc::LabelingResult proc::labelComponents(const cv::Mat& binary, int connectivity)
+{
+    CV_Assert(binary.channels() == 1 && binary.type() == CV_8U);
+    return labelComponentsImpl(ByteRunSource{binary}, connectivity);
+}
+
+proc::LabelingResult proc::labelComponents(const BitImage& binary, int connectivity)
+{
+    return labelComponentsImpl(BitRunSource{binary}, connectivity);
+}
+
+proc::BitImage proc::morphology(const BitImage& src, MorphOp op, int kernelWidth, int kernelHeight)
+{
+    CV_Assert(kernelWidth >= 1 && kernelHeight >= 1);
+
+    switch (op) {
+        case MorphOp::Erode:
+            return erodeRect(src, kernelWidth, kernelHeight);
+        case MorphOp::Dilate:
+            return dilateRect(src, kernelWidth, kernelHeight);
+        case MorphOp::Open:
+            return dilateRect(erodeRect(src, kernelWidth, kernelHeight), kernelWidth, kernelHeight);
+        case MorphOp::Close:
+            return erodeRect(dilateRect(src, kernelWidth, kernelHeight), kernelWidth, kernelHeight);
+    }
+    return src;
+}
+
+cv::Mat proc::morphology(const cv::Mat& binary, MorphOp op, int kernelWidth, int kernelHeight)
+{
+    CV_Assert(binary.channels() == 1 && binary.type() == CV_8U);
+    return unpackBinary(morphology(packBinary(binary), op, kernelWidth, kernelHeight));
+}
+
+cv::Mat proc::colorizeLabels(const cv::Mat& labels)
+{
+    CV_Assert(labels.type() == CV_32S);
+    cv::Mat dest(labels.rows, labels.cols, CV_8UC3);
+
+    for (int y = 0; y < labels.rows; y++) {
+        const int* src = labels.ptr<int>(y);
+        cv::Vec3b* dst = dest.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < labels.cols; x++) {
+            unsigned l = (unsigned)src[x];
+            if (l == 0) {
+                dst[x] = cv::Vec3b(0, 0, 0);
+            } else {
+                unsigned h = l * 2654435761u;
+                dst[x] = cv::Vec3b(64 + (h & 0xBF), 64 + ((h >> 8) & 0xBF), 64 + ((h >> 16) & 0xBF));
+            }
+        }
+    }
+    return dest;
+}
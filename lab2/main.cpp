@@ -1,11 +1,22 @@
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <opencv2/opencv.hpp>
 #include "proclib.hpp"
 
 cv::Mat g_srcImage, g_destImage;
+cv::Mat g_baseImage; // Вход для операций: исходник или результат выравнивания
+bool g_destIsBinary = false; // Результат - бинарное изображение 0/255
 int g_manualThreshold = 128;
 const int g_thresholdMax = 255;
+int g_claheClip = 20; // Предел контраста CLAHE, умноженный на 10
+const int g_claheClipMax = 100;
+int g_kernelSize = 3; // Сторона квадратного элемента морфологии
+const int g_kernelSizeMax = 51;
+int g_unsharpRadius = 5; // Сигма размытия нерезкой маски, пикселей
+const int g_unsharpRadiusMax = 100;
+int g_unsharpAmount = 100; // Сила нерезкой маски в процентах
+const int g_unsharpAmountMax = 500;
 
 const char* g_windowSrc = "Original";
 const char* g_windowDest = "Result";
@@ -18,6 +29,167 @@ const char* g_windowDest = "Result";
 void onTrackbar(int, void*) {
 }
 
+/**
+ * @brief Бинарное изображение для морфологии и разметки.
+ * Если результат еще не бинарный, изображение бинаризуется по Оцу
+ * сразу в упакованный вид.
+ */
+proc::BitImage toBinaryPacked(const cv::Mat& image, bool isBinary) {
+    return isBinary ? proc::packBinary(image) : proc::otsuThresholdPacked(image);
+}
+
+/**
+ * @brief Размечает связные компоненты и выводит пять крупнейших.
+ * @return Раскрашенное изображение меток.
+ */
+cv::Mat applyLabeling(const proc::BitImage& binary) {
+    proc::LabelingResult result = proc::labelComponents(binary);
+
+    std::cout << "Components found: " << result.components.size() << std::endl;
+
+    std::vector<proc::ComponentStats> largest = result.components;
+    size_t top = std::min<size_t>(5, largest.size());
+    std::partial_sort(largest.begin(), largest.begin() + top, largest.end(),
+        [](const proc::ComponentStats& a, const proc::ComponentStats& b) { return a.area > b.area; });
+    for (size_t i = 0; i < top; i++) {
+        const proc::ComponentStats& c = largest[i];
+        std::cout << "  #" << c.label << ": area=" << c.area
+                  << " bbox=[" << c.left << "," << c.top << " - " << c.right << "," << c.bottom << "]"
+                  << " centroid=(" << c.cx << ", " << c.cy << ")" << std::endl;
+    }
+
+    return proc::colorizeLabels(result.labels);
+}
+
+/**
+ * @brief Разбирает размер элемента "K" или "WxH".
+ */
+bool parseKernel(const std::string& arg, int& width, int& height) {
+    try {
+        size_t x = arg.find('x');
+        width = std::stoi(arg.substr(0, x));
+        height = (x == std::string::npos) ? width : std::stoi(arg.substr(x + 1));
+    } catch (...) {
+        return false;
+    }
+    return width >= 1 && height >= 1;
+}
+
+/**
+ * @brief Разбирает параметры нерезкой маски "R[,A[,T]]" (A - сила в долях).
+ */
+bool parseUnsharp(const std::string& arg, double& radius, double& amount, int& threshold) {
+    try {
+        size_t c1 = arg.find(',');
+        size_t c2 = (c1 == std::string::npos) ? c1 : arg.find(',', c1 + 1);
+        radius = std::stod(arg.substr(0, c1));
+        if (c1 != std::string::npos) amount = std::stod(arg.substr(c1 + 1, c2 - c1 - 1));
+        if (c2 != std::string::npos) threshold = std::stoi(arg.substr(c2 + 1));
+    } catch (...) {
+        return false;
+    }
+    return radius > 0 && amount >= 0 && threshold >= 0;
+}
+
+/**
+ * @brief Пакетный режим: применяет цепочку операций к изображению без окон.
+ * Формат: ImageLab --batch <вход> <выход> <операция>...
+ * Операции: sharpen, unsharp:R[,A[,T]], equalize, clahe[:clip], otsu, threshold:N, label,
+ *           erode:K, dilate:K, open:K, close:K (K - сторона или WxH).
+ * Морфология и разметка бинаризуют небинарный вход по Оцу.
+ */
+int runBatch(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: ImageLab --batch <input> <output> <op>..." << std::endl;
+        return -1;
+    }
+
+    cv::Mat image = cv::imread(argv[2]);
+    if (image.empty()) {
+        std::cerr << "Ошибка: Не удалось загрузить изображение: " << argv[2] << std::endl;
+        return -1;
+    }
+    bool binary = false;
+
+    try {
+        for (int i = 4; i < argc; i++) {
+            std::string spec = argv[i];
+            size_t colon = spec.find(':');
+            std::string name = spec.substr(0, colon);
+            std::string arg = (colon == std::string::npos) ? "" : spec.substr(colon + 1);
+
+            int kernelWidth = 0, kernelHeight = 0;
+            proc::MorphOp op = proc::MorphOp::Erode;
+            bool isMorph = true;
+            if (name == "erode") op = proc::MorphOp::Erode;
+            else if (name == "dilate") op = proc::MorphOp::Dilate;
+            else if (name == "open") op = proc::MorphOp::Open;
+            else if (name == "close") op = proc::MorphOp::Close;
+            else isMorph = false;
+
+            std::cout << "Applying: " << spec << std::endl;
+            if (isMorph) {
+                if (!parseKernel(arg.empty() ? "3" : arg, kernelWidth, kernelHeight)) {
+                    std::cerr << "Ошибка: неверный размер элемента: " << spec << std::endl;
+                    return -1;
+                }
+                image = proc::unpackBinary(proc::morphology(toBinaryPacked(image, binary), op, kernelWidth, kernelHeight));
+                binary = true;
+            } else if (name == "sharpen") {
+                image = proc::sharpen(image);
+                binary = false;
+            } else if (name == "unsharp") {
+                double radius = g_unsharpRadius, amount = g_unsharpAmount / 100.0;
+                int threshold = 0;
+                if (!arg.empty() && !parseUnsharp(arg, radius, amount, threshold)) {
+                    std::cerr << "Ошибка: неверные параметры маски: " << spec << std::endl;
+                    return -1;
+                }
+                image = proc::unsharpMask(image, radius, amount, threshold);
+                binary = false;
+            } else if (name == "equalize") {
+                image = proc::equalizeHistogram(image);
+                binary = false;
+            } else if (name == "clahe") {
+                image = proc::clahe(image, arg.empty() ? 2.0 : std::stod(arg));
+                binary = false;
+            } else if (name == "otsu") {
+                image = proc::otsuThreshold(image);
+                binary = true;
+            } else if (name == "threshold") {
+                image = proc::manualThreshold(image, arg.empty() ? g_manualThreshold : std::stoi(arg));
+                binary = true;
+            } else if (name == "label") {
+                image = applyLabeling(toBinaryPacked(image, binary));
+                binary = false;
+            } else {
+                std::cerr << "Ошибка: неизвестная операция: " << spec << std::endl;
+                return -1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: неверный аргумент операции: " << e.what() << std::endl;
+        return -1;
+    }
+
+    if (!cv::imwrite(argv[3], image)) {
+        std::cerr << "Ошибка: Не удалось сохранить изображение: " << argv[3] << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Применяет морфологию к текущему результату (клавиши 1-4).
+ */
+void applyMorphology(proc::MorphOp op, const char* name) {
+    int k = std::max(1, g_kernelSize);
+    std::cout << "Applying: " << name << " (Kernel: " << k << "x" << k << ")" << std::endl;
+    const cv::Mat& input = g_destIsBinary ? g_destImage : g_baseImage;
+    g_destImage = proc::unpackBinary(proc::morphology(toBinaryPacked(input, g_destIsBinary), op, k, k));
+    g_destIsBinary = true;
+}
+
 /**
  * @brief Выводит инструкции в консоль.
  */
@@ -25,15 +197,24 @@ void printInstructions() {
     std::cout << "\n--- Управление ---" << std::endl;
     std::cout << "Нажмите клавишу в окне:" << std::endl;
     std::cout << "  's' - Увеличить резкость (Sharpen)" << std::endl;
+    std::cout << "  'u' - Нерезкая маска (Unsharp Mask)" << std::endl;
     std::cout << "  'o' - Порог Оцу (Otsu)" << std::endl;
     std::cout << "  't' - Ручной порог (Threshold)" << std::endl;
+    std::cout << "  'l' - Связные компоненты (Labeling)" << std::endl;
+    std::cout << "  'e' - Выравнивание гистограммы (Equalize)" << std::endl;
+    std::cout << "  'c' - Адаптивное выравнивание (CLAHE)" << std::endl;
+    std::cout << "  '1'/'2'/'3'/'4' - Эрозия / Дилатация / Открытие / Закрытие" << std::endl;
     std::cout << "  'r' - Сброс (Reset)" << std::endl;
     std::cout << "  'q' - Выход (Quit)" << std::endl;
     std::cout << "------------------" << std::endl;
 }
 
 int main(int argc, char** argv) {
-    
+
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+
     std::string imagePath = "../test1.jpg"; // Изображение по умолчанию
     if (argc > 1) {
         imagePath = "../" + std::string(argv[1]);
@@ -48,12 +229,17 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    g_baseImage = g_srcImage;
     g_destImage = g_srcImage.clone();
 
     cv::namedWindow(g_windowSrc, cv::WINDOW_AUTOSIZE);
     cv::namedWindow(g_windowDest, cv::WINDOW_AUTOSIZE);
 
     cv::createTrackbar("Threshold", g_windowDest, &g_manualThreshold, g_thresholdMax, onTrackbar);
+    cv::createTrackbar("CLAHE clip x10", g_windowDest, &g_claheClip, g_claheClipMax, onTrackbar);
+    cv::createTrackbar("Kernel", g_windowDest, &g_kernelSize, g_kernelSizeMax, onTrackbar);
+    cv::createTrackbar("Unsharp radius", g_windowDest, &g_unsharpRadius, g_unsharpRadiusMax, onTrackbar);
+    cv::createTrackbar("Unsharp amount %", g_windowDest, &g_unsharpAmount, g_unsharpAmountMax, onTrackbar);
 
     cv::imshow(g_windowSrc, g_srcImage);
     cv::imshow(g_windowDest, g_destImage);
@@ -70,22 +256,70 @@ int main(int argc, char** argv) {
 
             case 'r':
                 std::cout << "Applying: Reset" << std::endl;
+                g_baseImage = g_srcImage;
                 g_destImage = g_srcImage.clone();
+                g_destIsBinary = false;
                 break;
 
             case 's':
                 std::cout << "Applying: Sharpen" << std::endl;
-                g_destImage = proc::sharpen(g_srcImage);
+                g_destImage = proc::sharpen(g_baseImage);
+                g_destIsBinary = false;
+                break;
+
+            case 'u':
+                std::cout << "Applying: Unsharp Mask (Radius: " << std::max(1, g_unsharpRadius)
+                          << ", Amount: " << g_unsharpAmount << "%)" << std::endl;
+                g_destImage = proc::unsharpMask(g_baseImage, std::max(1, g_unsharpRadius), g_unsharpAmount / 100.0);
+                g_destIsBinary = false;
                 break;
 
             case 'o':
                 std::cout << "Applying: Otsu Threshold" << std::endl;
-                g_destImage = proc::otsuThreshold(g_srcImage);
+                g_destImage = proc::otsuThreshold(g_baseImage);
+                g_destIsBinary = true;
                 break;
 
             case 't':
                 std::cout << "Applying: Manual Threshold (Value: " << g_manualThreshold << ")" << std::endl;
-                g_destImage = proc::manualThreshold(g_srcImage, g_manualThreshold);
+                g_destImage = proc::manualThreshold(g_baseImage, g_manualThreshold);
+                g_destIsBinary = true;
+                break;
+
+            case 'l':
+                std::cout << "Applying: Connected Components" << std::endl;
+                g_destImage = applyLabeling(toBinaryPacked(g_destIsBinary ? g_destImage : g_baseImage, g_destIsBinary));
+                g_destIsBinary = false;
+                break;
+
+            case 'e':
+                std::cout << "Applying: Histogram Equalization" << std::endl;
+                g_destImage = proc::equalizeHistogram(g_srcImage);
+                g_baseImage = g_destImage;
+                g_destIsBinary = false;
+                break;
+
+            case 'c':
+                std::cout << "Applying: CLAHE (Clip: " << g_claheClip / 10.0 << ")" << std::endl;
+                g_destImage = proc::clahe(g_srcImage, g_claheClip / 10.0);
+                g_baseImage = g_destImage;
+                g_destIsBinary = false;
+                break;
+
+            case '1':
+                applyMorphology(proc::MorphOp::Erode, "Erode");
+                break;
+
+            case '2':
+                applyMorphology(proc::MorphOp::Dilate, "Dilate");
+                break;
+
+            case '3':
+                applyMorphology(proc::MorphOp::Open, "Open");
+                break;
+
+            case '4':
+                applyMorphology(proc::MorphOp::Close, "Close");
                 break;
         }
         cv::imshow(g_windowDest, g_destImage);
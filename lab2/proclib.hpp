@@ -2,6 +2,8 @@
 #define PROCESSING_HPP
 
 #include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
 
 /**
  * @brief Пространство имен для функций обработки изображений.
@@ -15,6 +17,19 @@ namespace proc
      */
     cv::Mat sharpen(const cv::Mat& src);
 
+    /**
+     * @brief Нерезкое маскирование: d = s + amount * (s - blur(s)).
+     * Гауссиана приближается тремя прямоугольными размытиями скользящей суммой;
+     * каждое разделимо на горизонтальный и вертикальный проходы, строки и полосы
+     * столбцов обрабатываются параллельно, а работа на пиксель не зависит от радиуса.
+     * @param src Исходное изображение (1-4 канала, приводится к 8 битам).
+     * @param radius Сигма гауссианы в пикселях (1-100).
+     * @param amount Сила: 1.0 удваивает отличие пикселя от размытого.
+     * @param threshold Пиксели, отличающиеся от размытого меньше чем на threshold (0-255), не меняются.
+     * @return Изображение того же числа каналов с повышенной резкостью.
+     */
+    cv::Mat unsharpMask(const cv::Mat& src, double radius, double amount = 1.0, int threshold = 0);
+
     /**
      * @brief Применяет ручную глобальную пороговую обработку.
      * @param src Исходное изображение (будет преобразовано в оттенки серого).
@@ -30,6 +45,137 @@ namespace proc
      */
     cv::Mat otsuThreshold(const cv::Mat& src);
 
+    /**
+     * @brief Глобальное выравнивание гистограммы.
+     * @param src Исходное изображение (будет преобразовано в оттенки серого).
+     * @return Изображение в оттенках серого с выровненной гистограммой.
+     */
+    cv::Mat equalizeHistogram(const cv::Mat& src);
+
+    /**
+     * @brief Адаптивное выравнивание гистограммы с ограничением контраста (CLAHE).
+     * Гистограммы плиток считаются параллельно, таблицы соседних плиток
+     * интерполируются билинейно по разделимой схеме.
+     * @param src Исходное изображение (будет преобразовано в оттенки серого).
+     * @param clipLimit Предел высоты столбца относительно среднего (0 - без ограничения).
+     * @param tilesX Число плиток по горизонтали.
+     * @param tilesY Число плиток по вертикали.
+     * @return Изображение в оттенках серого.
+     */
+    cv::Mat clahe(const cv::Mat& src, double clipLimit = 2.0, int tilesX = 8, int tilesY = 8);
+
+    /**
+     * @brief Упакованное бинарное изображение: 64 пикселя в одном машинном слове.
+     * Пиксель (x, y) хранится в бите (x % 64) слова (x / 64) строки y.
+     * Биты за пределами cols в последнем слове строки всегда нулевые.
+     */
+    struct BitImage
+    {
+        int rows = 0;
+        int cols = 0;
+        int wordsPerRow = 0;
+        std::vector<uint64_t> words;
+
+        BitImage() = default;
+        BitImage(int rows, int cols);
+
+        uint64_t* row(int y) { return words.data() + (size_t)y * wordsPerRow; }
+        const uint64_t* row(int y) const { return words.data() + (size_t)y * wordsPerRow; }
+        bool get(int x, int y) const { return (row(y)[x >> 6] >> (x & 63)) & 1u; }
+        bool empty() const { return rows == 0 || cols == 0; }
+    };
+
+    /**
+     * @brief Упаковывает бинарное изображение (CV_8U, ненулевой пиксель = 1) в BitImage.
+     */
+    BitImage packBinary(const cv::Mat& binary);
+
+    /**
+     * @brief Распаковывает BitImage в изображение CV_8U со значениями 0/255.
+     */
+    cv::Mat unpackBinary(const BitImage& bits);
+
+    /**
+     * @brief Ручной порог сразу в упакованный вид (пиксель > threshold -> 1).
+     */
+    BitImage manualThresholdPacked(const cv::Mat& src, int threshold);
+
+    /**
+     * @brief Порог Оцу сразу в упакованный вид.
+     */
+    BitImage otsuThresholdPacked(const cv::Mat& src);
+
+    /**
+     * @brief Операция бинарной морфологии.
+     */
+    enum class MorphOp
+    {
+        Erode,
+        Dilate,
+        Open,   ///< Эрозия, затем дилатация: убирает мелкий шум.
+        Close   ///< Дилатация, затем эрозия: закрывает мелкие дыры.
+    };
+
+    /**
+     * @brief Бинарная морфология прямоугольным элементом с якорем в центре.
+     * Работает по 64 пикселя на машинное слово; прямоугольник раскладывается
+     * на горизонтальный и вертикальный проходы (ван Херк / Гиль-Верман),
+     * так что стоимость не зависит от размера ядра. Строки и столбцы слов
+     * обрабатываются параллельно.
+     * @param src Упакованное бинарное изображение.
+     * @param op Операция.
+     * @param kernelWidth Ширина элемента (>= 1).
+     * @param kernelHeight Высота элемента (>= 1).
+     */
+    BitImage morphology(const BitImage& src, MorphOp op, int kernelWidth, int kernelHeight);
+
+    /**
+     * @brief Бинарная морфология для байтового изображения (через упаковку).
+     * @return Изображение CV_8U со значениями 0/255.
+     */
+    cv::Mat morphology(const cv::Mat& binary, MorphOp op, int kernelWidth, int kernelHeight);
+
+    /**
+     * @brief Статистика одной связной компоненты.
+     */
+    struct ComponentStats
+    {
+        int label = 0;          ///< Метка компоненты в изображении меток (1..N).
+        int64_t area = 0;       ///< Площадь в пикселях.
+        int left = 0, top = 0;  ///< Ограничивающий прямоугольник (включительно).
+        int right = 0, bottom = 0;
+        double cx = 0, cy = 0;  ///< Центр масс.
+    };
+
+    /**
+     * @brief Результат разметки связных компонент.
+     */
+    struct LabelingResult
+    {
+        cv::Mat labels;                         ///< CV_32S, 0 - фон, 1..N - компоненты.
+        std::vector<ComponentStats> components; ///< components[i] описывает метку i + 1.
+    };
+
+    /**
+     * @brief Разметка связных компонент бинарного изображения.
+     * Полосы строк размечаются параллельно (union-find по сериям пикселей),
+     * метки на границах полос затем объединяются. Площадь, рамка и центр масс
+     * считаются в том же проходе, без повторного чтения изображения.
+     * @param binary Бинарное изображение CV_8U (ненулевой пиксель - объект).
+     * @param connectivity Связность: 4 или 8.
+     */
+    LabelingResult labelComponents(const cv::Mat& binary, int connectivity = 8);
+
+    /**
+     * @brief Разметка связных компонент упакованного бинарного изображения.
+     */
+    LabelingResult labelComponents(const BitImage& binary, int connectivity = 8);
+
+    /**
+     * @brief Раскрашивает изображение меток для просмотра (фон - черный).
+     */
+    cv::Mat colorizeLabels(const cv::Mat& labels);
+
 } // namespace proc
 
 #endif // PROCESSING_HPP
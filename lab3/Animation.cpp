@@ -0,0 +1,49 @@
+#include "rasteranim.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void raster::PlaybackScheduler::start()
+{
+    m_credit = 0;
+    m_first_us = -1;
+    m_last_us = -1;
+    m_stats = PlaybackStats();
+}
+
+uint64_t raster::PlaybackScheduler::begin_frame(int64_t now_us, int64_t refresh_us)
+{
+    if (refresh_us > 0) m_refresh_us = refresh_us;
+
+    // Первый кадр получает один период; дальше - время с прошлого кадра
+    int64_t dt = m_refresh_us;
+    if (m_last_us >= 0) {
+        dt = std::max<int64_t>(0, now_us - m_last_us);
+        if (dt * 2 > m_refresh_us * 3) m_stats.dropped_frames += (uint64_t)std::llround((double)dt / m_refresh_us) - 1;
+        dt = std::min<int64_t>(dt, MAX_CATCHUP_FRAMES * m_refresh_us);
+    } else {
+        m_first_us = now_us;
+    }
+    m_last_us = now_us;
+
+    if (m_rate <= 0) return UINT64_MAX;
+    m_credit += m_rate * dt * 1e-6;
+    if (m_credit <= 0) return 0;
+    return (uint64_t)std::ceil(m_credit);
+}
+
+void raster::PlaybackScheduler::end_frame(uint64_t played, int64_t work_us, bool out_of_time)
+{
+    if (played > 0) {
+        ++m_stats.frames;
+        m_stats.pixels += played;
+    }
+    if (out_of_time) ++m_stats.late_frames;
+    m_stats.max_work_us = std::max(m_stats.max_work_us, work_us);
+    m_stats.elapsed_us = m_last_us - m_first_us + m_refresh_us;
+
+    if (m_rate <= 0) return;
+    m_credit -= (double)played;
+    // Скорость недостижима: недобор не копится, иначе очередь будет бесконечно "догонять"
+    if (out_of_time) m_credit = std::min(m_credit, 0.0);
+}
@@ -0,0 +1,169 @@
+#include "rasterbatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    /**
+     * @brief Приемник, пишущий в буфер кадра без проверок границ:
+     * отсеченные алгоритмы не выходят за прямоугольник плитки.
+     */
+    class TileSink : public raster::PixelSink
+    {
+    public:
+        TileSink(raster::Framebuffer& fb, raster::Rgba8 color)
+            : m_fb(fb), m_data(fb.data()), m_width(fb.width()), m_color(color)
+        {
+            m_packed = (uint32_t)color.b | ((uint32_t)color.g << 8) | ((uint32_t)color.r << 16) | (0xFFu << 24);
+        }
+
+        void pixel(int x, int y, uint8_t alpha) override
+        {
+            if (alpha == 255) std::memcpy(m_data + ((size_t)y * m_width + x) * 4, &m_packed, 4);
+            else m_fb.blend_coverage(x, y, m_color, alpha);
+        }
+
+        void pixel_pair(raster::SpanKind kind, int x, int y, uint8_t a0, uint8_t a1) override
+        {
+            m_fb.blend_coverage_pair(kind, x, y, m_color, a0, a1);
+        }
+
+        void span(raster::SpanKind kind, int x, int y, int len) override
+        {
+            uint32_t* p = reinterpret_cast<uint32_t*>(m_data) + (size_t)y * m_width + x;
+            if (kind == raster::SPAN_HORIZONTAL) {
+                std::fill_n(p, len, m_packed);
+            } else {
+                for (int i = 0; i < len; ++i, p += m_width) *p = m_packed;
+            }
+        }
+
+    private:
+        raster::Framebuffer& m_fb;
+        uint8_t* m_data;
+        int m_width;
+        raster::Rgba8 m_color;
+        uint32_t m_packed;
+    };
+
+    /**
+     * @brief Геометрия разбиения холста на плитки.
+     */
+    struct TileGrid
+    {
+        int width, height, size, tiles_x, tiles_y;
+
+        raster::ClipRect rect(size_t tile) const
+        {
+            int tx = (int)(tile % tiles_x), ty = (int)(tile / tiles_x);
+            return { tx * size, ty * size,
+                     std::min(width, (tx + 1) * size) - 1, std::min(height, (ty + 1) * size) - 1 };
+        }
+    };
+
+    /**
+     * @brief Перебирает плитки, которые может задеть отрезок.
+     * Идет по строкам плиток и для каждой берет диапазон x идеальной прямой
+     * в полосе строки, расширенной на margin: пиксели Брезенхема отстоят от
+     * прямой не больше чем на 0.5, пиксели Ву - не больше чем на 1.
+     * Лишняя плитка безопасна (отсечение там ничего не нарисует), пропущенных нет.
+     */
+    template <class F>
+    void for_each_tile(const raster::Segment& s, const TileGrid& g, F&& f)
+    {
+        const int margin = 2;
+        int min_x = std::min(s.x1, s.x2) - 1, max_x = std::max(s.x1, s.x2) + 1;
+        int min_y = std::min(s.y1, s.y2) - 1, max_y = std::max(s.y1, s.y2) + 1;
+        if (max_x < 0 || max_y < 0 || min_x >= g.width || min_y >= g.height) return;
+
+        int ty0 = std::max(min_y, 0) / g.size;
+        int ty1 = std::min(max_y, g.height - 1) / g.size;
+        double inv = (s.y1 == s.y2) ? 0.0 : (double)(s.x2 - s.x1) / (s.y2 - s.y1);
+
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            int xa = min_x, xb = max_x;
+            if (s.y1 != s.y2) {
+                double ya = std::max(ty * g.size, min_y) - margin;
+                double yb = std::min(ty * g.size + g.size - 1, max_y) + margin;
+                double u = s.x1 + (ya - s.y1) * inv, v = s.x1 + (yb - s.y1) * inv;
+                xa = std::max(min_x, (int)std::floor(std::min(u, v)) - margin);
+                xb = std::min(max_x, (int)std::ceil(std::max(u, v)) + margin);
+            }
+            if (xb < 0 || xa >= g.width) continue;
+            int tx0 = std::max(xa, 0) / g.size;
+            int tx1 = std::min(xb, g.width - 1) / g.size;
+            for (int tx = tx0; tx <= tx1; ++tx) f((size_t)ty * g.tiles_x + tx);
+        }
+    }
+} // namespace
+
+
+raster::BatchStats raster::render_segments(Framebuffer& fb, const Segment* segments, size_t count, Rgba8 color,
+                                           BatchAlgorithm algorithm, ThreadPool& pool, int tile_size)
+{
+    BatchStats stats;
+    if (count == 0 || fb.width() == 0 || fb.height() == 0) return stats;
+
+    TileGrid grid;
+    grid.width = fb.width();
+    grid.height = fb.height();
+    grid.size = std::max(8, tile_size);
+    grid.tiles_x = (grid.width + grid.size - 1) / grid.size;
+    grid.tiles_y = (grid.height + grid.size - 1) / grid.size;
+    size_t tiles = (size_t)grid.tiles_x * grid.tiles_y;
+
+    const size_t chunk = 4096;
+    size_t chunks = (count + chunk - 1) / chunk;
+
+    // 1. Сколько отрезков попадает в каждую плитку
+    std::unique_ptr<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[tiles]);
+    for (size_t t = 0; t < tiles; ++t) counts[t].store(0, std::memory_order_relaxed);
+    pool.parallel_for(chunks, [&](size_t c, unsigned) {
+        size_t end = std::min(count, (c + 1) * chunk);
+        for (size_t i = c * chunk; i < end; ++i)
+            for_each_tile(segments[i], grid, [&](size_t t) { counts[t].fetch_add(1, std::memory_order_relaxed); });
+    });
+
+    // 2. Смещения списков плиток и их заполнение
+    std::vector<uint32_t> offsets(tiles + 1, 0);
+    std::vector<uint32_t> active;
+    for (size_t t = 0; t < tiles; ++t) {
+        uint32_t n = counts[t].load(std::memory_order_relaxed);
+        offsets[t + 1] = offsets[t] + n;
+        if (n) active.push_back((uint32_t)t);
+        counts[t].store(offsets[t], std::memory_order_relaxed);
+    }
+    std::vector<uint32_t> refs(offsets[tiles]);
+    pool.parallel_for(chunks, [&](size_t c, unsigned) {
+        size_t end = std::min(count, (c + 1) * chunk);
+        for (size_t i = c * chunk; i < end; ++i)
+            for_each_tile(segments[i], grid, [&](size_t t) {
+                refs[counts[t].fetch_add(1, std::memory_order_relaxed)] = (uint32_t)i;
+            });
+    });
+
+    // 3. Плитки независимы: каждую рисует один поток, отрезки - в порядке индексов
+    pool.parallel_for(active.size(), [&](size_t k, unsigned) {
+        size_t t = active[k];
+        uint32_t* first = refs.data() + offsets[t];
+        uint32_t* last = refs.data() + offsets[t + 1];
+        std::sort(first, last);
+
+        ClipRect clip = grid.rect(t);
+        TileSink sink(fb, color);
+        for (const uint32_t* it = first; it != last; ++it) {
+            const Segment& s = segments[*it];
+            if (algorithm == BatchAlgorithm::Wu) wu_line_clipped(sink, s.x1, s.y1, s.x2, s.y2, clip);
+            else bresenham_line_clipped(sink, s.x1, s.y1, s.x2, s.y2, clip);
+        }
+    });
+
+    stats.tiles = active.size();
+    stats.tile_refs = refs.size();
+    return stats;
+}
@@ -0,0 +1,233 @@
+#include "rasterbench.hpp"
+#include "rasterfill.hpp"
+#include "rasterstroke.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    const double PI = 3.14159265358979323846;
+
+    void draw_step(raster::PixelSink& sink, const raster::Segment& s) { raster::step_line(sink, s.x1, s.y1, s.x2, s.y2); }
+    void draw_dda(raster::PixelSink& sink, const raster::Segment& s) { raster::dda_line(sink, s.x1, s.y1, s.x2, s.y2); }
+    void draw_step_ref(raster::PixelSink& sink, const raster::Segment& s) { raster::step_line_reference(sink, s.x1, s.y1, s.x2, s.y2); }
+    void draw_dda_ref(raster::PixelSink& sink, const raster::Segment& s) { raster::dda_line_reference(sink, s.x1, s.y1, s.x2, s.y2); }
+    void draw_bresenham(raster::PixelSink& sink, const raster::Segment& s) { raster::bresenham_line(sink, s.x1, s.y1, s.x2, s.y2); }
+    void draw_wu(raster::PixelSink& sink, const raster::Segment& s) { raster::wu_line(sink, s.x1, s.y1, s.x2, s.y2); }
+    void draw_castle(raster::PixelSink& sink, const raster::Segment& s) { raster::castle_pitteway_line(sink, s.x1, s.y1, s.x2, s.y2); }
+
+    // Окружность с диаметром-отрезком
+    void draw_circle(raster::PixelSink& sink, const raster::Segment& s)
+    {
+        int r = (int)std::lround(std::hypot(s.x2 - s.x1, s.y2 - s.y1) / 2);
+        raster::bresenham_circle(sink, (s.x1 + s.x2) / 2, (s.y1 + s.y2) / 2, r);
+    }
+
+    // Кривая с контрольной точкой на перпендикуляре к середине отрезка
+    void draw_bezier(raster::PixelSink& sink, const raster::Segment& s)
+    {
+        int mx = (s.x1 + s.x2) / 2, my = (s.y1 + s.y2) / 2;
+        int cx = mx - (s.y2 - s.y1) / 4, cy = my + (s.x2 - s.x1) / 4;
+        raster::bezier_quadratic(sink, s.x1, s.y1, cx, cy, s.x2, s.y2);
+    }
+
+    void draw_bezier_ref(raster::PixelSink& sink, const raster::Segment& s)
+    {
+        int mx = (s.x1 + s.x2) / 2, my = (s.y1 + s.y2) / 2;
+        int cx = mx - (s.y2 - s.y1) / 4, cy = my + (s.x2 - s.x1) / 4;
+        raster::bezier_quadratic_reference(sink, s.x1, s.y1, cx, cy, s.x2, s.y2);
+    }
+
+    // S-образная кривая: контрольные точки по разные стороны отрезка
+    void draw_cubic(raster::PixelSink& sink, const raster::Segment& s)
+    {
+        int px = -(s.y2 - s.y1) / 4, py = (s.x2 - s.x1) / 4;
+        raster::bezier_cubic(sink, s.x1, s.y1, (2 * s.x1 + s.x2) / 3 + px, (2 * s.y1 + s.y2) / 3 + py,
+                             (s.x1 + 2 * s.x2) / 3 - px, (s.y1 + 2 * s.y2) / 3 - py, s.x2, s.y2);
+    }
+
+    // Заливка без отсечения: приемник сам отсекает по холсту
+    const raster::ClipRect NO_CLIP = {-(1 << 30), -(1 << 30), 1 << 30, 1 << 30};
+
+    // Круг с диаметром-отрезком
+    void draw_fill_circle(raster::PixelSink& sink, const raster::Segment& s)
+    {
+        int r = (int)std::lround(std::hypot(s.x2 - s.x1, s.y2 - s.y1) / 2);
+        raster::fill_circle(sink, (s.x1 + s.x2) / 2, (s.y1 + s.y2) / 2, r, NO_CLIP);
+    }
+
+    // Треугольник с основанием-отрезком и вершиной на перпендикуляре к его середине
+    void draw_fill_polygon(raster::PixelSink& sink, const raster::Segment& s)
+    {
+        raster::PointD tri[3] = {{(double)s.x1, (double)s.y1},
+                                 {(double)s.x2, (double)s.y2},
+                                 {(s.x1 + s.x2) / 2.0 - (s.y2 - s.y1) / 2.0, (s.y1 + s.y2) / 2.0 + (s.x2 - s.x1) / 2.0}};
+        raster::fill_polygon(sink, tri, 3, raster::FillRule::NonZero, NO_CLIP);
+    }
+
+    // Отрезок со сдвигом (dx, dy), обрезанным по холсту; начало выбирается так, чтобы конец тоже оказался на холсте
+    raster::Segment place_segment(std::mt19937& rng, int dx, int dy, int width, int height)
+    {
+        dx = std::clamp(dx, -(width - 1), width - 1);
+        dy = std::clamp(dy, -(height - 1), height - 1);
+        std::uniform_int_distribution<int> px(std::max(0, -dx), std::min(width - 1, width - 1 - dx));
+        std::uniform_int_distribution<int> py(std::max(0, -dy), std::min(height - 1, height - 1 - dy));
+        int x1 = px(rng), y1 = py(rng);
+        return {x1, y1, x1 + dx, y1 + dy};
+    }
+
+    // Ломаная с изломом в середине отрезка: два отрезка, стык и два конца
+    void draw_stroke_width(raster::PixelSink& sink, const raster::Segment& s, double width)
+    {
+        thread_local raster::Polyline lines;
+        lines.clear();
+        lines.points = {{(double)s.x1, (double)s.y1},
+                        {(s.x1 + s.x2) / 2.0 - (s.y2 - s.y1) / 4.0, (s.y1 + s.y2) / 2.0 + (s.x2 - s.x1) / 4.0},
+                        {(double)s.x2, (double)s.y2}};
+        lines.starts.push_back(0);
+        lines.closed.push_back(0);
+        raster::StrokeStyle style;
+        style.width = width;
+        style.join = raster::LineJoin::Round;
+        style.cap = raster::LineCap::Round;
+        raster::stroke_polyline(sink, lines, style, NO_CLIP);
+    }
+
+    void draw_stroke(raster::PixelSink& sink, const raster::Segment& s) { draw_stroke_width(sink, s, 5); }
+    void draw_stroke_wide(raster::PixelSink& sink, const raster::Segment& s) { draw_stroke_width(sink, s, 51); }
+
+    double now_ns()
+    {
+        using clock = std::chrono::steady_clock;
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+    }
+} // namespace
+
+
+std::vector<raster::Segment> raster::random_segments(size_t count, int length, int width, int height, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * PI);
+    std::vector<Segment> out;
+    out.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        double a = angle(rng);
+        int dx = (int)std::lround(std::cos(a) * length);
+        int dy = (int)std::lround(std::sin(a) * length);
+        out.push_back(place_segment(rng, dx, dy, width, height));
+    }
+    return out;
+}
+
+std::vector<raster::Segment> raster::sloped_segments(size_t count, int length, double angle_deg, int width, int height, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    double a = angle_deg * PI / 180.0;
+    int dx = (int)std::lround(std::cos(a) * length);
+    int dy = (int)std::lround(std::sin(a) * length);
+    std::vector<Segment> out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) out.push_back(place_segment(rng, dx, dy, width, height));
+    return out;
+}
+
+raster::TimingStats raster::summarize(std::vector<double> samples_ns)
+{
+    TimingStats s;
+    s.samples = samples_ns.size();
+    if (samples_ns.empty()) return s;
+
+    std::sort(samples_ns.begin(), samples_ns.end());
+    size_t n = samples_ns.size();
+    s.min_ns = samples_ns.front();
+    s.median_ns = (n % 2) ? samples_ns[n / 2] : (samples_ns[n / 2 - 1] + samples_ns[n / 2]) / 2;
+    s.p99_ns = samples_ns[std::min(n - 1, (size_t)std::ceil(0.99 * n) - 1)];
+    double sum = 0;
+    for (double v : samples_ns) sum += v;
+    s.mean_ns = sum / n;
+    return s;
+}
+
+const std::vector<raster::BenchAlgorithm>& raster::bench_algorithms()
+{
+    static const std::vector<BenchAlgorithm> algorithms = {
+        {"step", draw_step},
+        {"dda", draw_dda},
+        {"bresenham", draw_bresenham},
+        {"circle", draw_circle},
+        {"wu", draw_wu},
+        {"bezier", draw_bezier},
+        {"castle", draw_castle},
+        {"cubic", draw_cubic},
+        {"fill_circle", draw_fill_circle},
+        {"fill_polygon", draw_fill_polygon},
+        {"stroke", draw_stroke},
+        {"stroke_wide", draw_stroke_wide},
+        {"step_ref", draw_step_ref},
+        {"dda_ref", draw_dda_ref},
+        {"bezier_ref", draw_bezier_ref},
+    };
+    return algorithms;
+}
+
+raster::BenchResult raster::run_benchmark(const BenchAlgorithm& algo, const std::vector<Segment>& segments,
+                                          PixelSink& sink, const char* sink_name, int warmup, int repetitions,
+                                          void (*prepare)(void* ctx), void* ctx)
+{
+    BenchResult r;
+    r.algorithm = algo.name;
+    r.sink = sink_name;
+    r.segments = segments.size();
+
+    CountingSink counter;
+    for (const Segment& s : segments) algo.draw(counter, s);
+    r.pixels = counter.pixels();
+
+    std::vector<double> samples;
+    samples.reserve(repetitions);
+    for (int rep = -warmup; rep < repetitions; ++rep) {
+        if (prepare) prepare(ctx);
+        double t0 = now_ns();
+        for (const Segment& s : segments) algo.draw(sink, s);
+        double t1 = now_ns();
+        if (rep >= 0) samples.push_back(t1 - t0);
+    }
+    r.stats = summarize(samples);
+    return r;
+}
+
+std::string raster::csv_header()
+{
+    return "algorithm,sink,length,angle,segments,pixels,min_ns,median_ns,p99_ns,ns_per_pixel,lines_per_sec,pixels_per_sec";
+}
+
+std::string raster::to_csv(const BenchResult& r)
+{
+    std::ostringstream os;
+    os << r.algorithm << ',' << r.sink << ',' << r.length << ',';
+    if (r.angle) os << *r.angle; else os << "random";
+    os << ',' << r.segments << ',' << r.pixels << ','
+       << r.stats.min_ns << ',' << r.stats.median_ns << ',' << r.stats.p99_ns << ','
+       << r.ns_per_pixel() << ',' << r.lines_per_sec() << ',' << r.pixels_per_sec();
+    return os.str();
+}
+
+std::string raster::to_json(const BenchResult& r)
+{
+    std::ostringstream os;
+    os << "{\"algorithm\":\"" << r.algorithm << "\",\"sink\":\"" << r.sink << "\",\"length\":" << r.length;
+    if (r.angle) os << ",\"angle\":" << *r.angle;
+    os << ",\"segments\":" << r.segments << ",\"pixels\":" << r.pixels
+       << ",\"min_ns\":" << r.stats.min_ns << ",\"median_ns\":" << r.stats.median_ns
+       << ",\"p99_ns\":" << r.stats.p99_ns << ",\"ns_per_pixel\":" << r.ns_per_pixel()
+       << ",\"lines_per_sec\":" << r.lines_per_sec() << ",\"pixels_per_sec\":" << r.pixels_per_sec() << "}";
+    return os.str();
+}
@@ -0,0 +1,132 @@
+#include "rasterlib.hpp"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    /**
+     * @brief Проигрывает команду в буфер кадра (Framebuffer или TiledFramebuffer).
+     */
+    template <class Target>
+    int play(Target& fb, const raster::DrawCommand& cmd, const raster::Rgba8& c, raster::BlendMode mode)
+    {
+        int len = cmd.length();
+        if (cmd.alpha != 255 && mode == raster::BlendMode::SourceOver) {
+            // Сглаживание: частичное покрытие смешивается гамма-корректно
+            for (int i = 0; i < len; ++i) {
+                if (cmd.kind() == raster::SPAN_HORIZONTAL) fb.blend_coverage(cmd.x + i, cmd.y, c, cmd.alpha);
+                else fb.blend_coverage(cmd.x, cmd.y + i, c, cmd.alpha);
+            }
+        } else {
+            fb.blend_span(cmd.kind(), cmd.x, cmd.y, len, c, cmd.alpha, mode);
+        }
+        return len;
+    }
+} // namespace
+
+
+bool raster::CommandBuffer::set_color(double r, double g, double b)
+{
+    Rgba8 c = rgba8(r, g, b);
+    for (size_t i = 0; i < m_palette.size(); ++i) {
+        const Rgba8& p = m_palette[i];
+        if (p.r == c.r && p.g == c.g && p.b == c.b && p.a == c.a) { m_color = (uint8_t)i; return true; }
+    }
+    if (m_palette.size() == 256 && !compact_palette()) return false;
+    m_palette.push_back(c);
+    m_color = (uint8_t)(m_palette.size() - 1);
+    return true;
+}
+
+bool raster::CommandBuffer::compact_palette()
+{
+    bool used[256] = {};
+    for (size_t i = m_read; i < m_cmds.size(); ++i) used[m_cmds[i].color] = true;
+    uint8_t remap[256];
+    size_t n = 0;
+    for (size_t i = 0; i < m_palette.size(); ++i) {
+        if (!used[i]) continue;
+        m_palette[n] = m_palette[i];
+        remap[i] = (uint8_t)n++;
+    }
+    if (n == m_palette.size()) return false;
+    m_palette.resize(n);
+    // Отыгранные команды палитру больше не читают, их индексы не трогаем
+    for (size_t i = m_read; i < m_cmds.size(); ++i) m_cmds[i].color = remap[m_cmds[i].color];
+    return true;
+}
+
+bool raster::CommandBuffer::try_extend(int x, int y, uint8_t alpha)
+{
+    if (m_cmds.size() == m_read) return false; // последняя команда уже отыграна
+    DrawCommand& last = m_cmds.back();
+    if (last.color != m_color || last.alpha != alpha) return false;
+    int len = last.length();
+    if (len >= DrawCommand::MAX_LEN) return false;
+
+    bool single = (len == 1);
+    if ((single || last.kind() == SPAN_HORIZONTAL) && y == last.y) {
+        if (x == last.x + len) { last.run = (uint16_t)((SPAN_HORIZONTAL << 14) | len); return true; }
+        if (x == last.x - 1)   { last.x = (int16_t)x; last.run = (uint16_t)((SPAN_HORIZONTAL << 14) | len); return true; }
+    }
+    if ((single || last.kind() == SPAN_VERTICAL) && x == last.x) {
+        if (y == last.y + len) { last.run = (uint16_t)((SPAN_VERTICAL << 14) | len); return true; }
+        if (y == last.y - 1)   { last.y = (int16_t)y; last.run = (uint16_t)((SPAN_VERTICAL << 14) | len); return true; }
+    }
+    return false;
+}
+
+void raster::CommandBuffer::append(SpanKind kind, int x, int y, int len, uint8_t alpha)
+{
+    while (len > 0) {
+        int part = std::min(len, DrawCommand::MAX_LEN);
+        m_cmds.push_back({ (int16_t)x, (int16_t)y, (uint16_t)((kind << 14) | (part - 1)), m_color, alpha });
+        if (kind == SPAN_HORIZONTAL) x += part; else y += part;
+        len -= part;
+    }
+}
+
+void raster::CommandBuffer::pixel(int x, int y, uint8_t alpha)
+{
+    const int lim = std::numeric_limits<int16_t>::max();
+    if (x < 0 || y < 0 || x > lim || y > lim) return; // вне любого холста
+    if (!try_extend(x, y, alpha)) append(SPAN_HORIZONTAL, x, y, 1, alpha);
+}
+
+void raster::CommandBuffer::span(SpanKind kind, int x, int y, int len)
+{
+    // Отсекаем части серии, не помещающиеся в 16-битные неотрицательные координаты
+    const int lim = std::numeric_limits<int16_t>::max();
+    int& along = (kind == SPAN_HORIZONTAL) ? x : y;
+    int across = (kind == SPAN_HORIZONTAL) ? y : x;
+    if (across < 0 || across > lim || len <= 0) return;
+    if (along < 0) { len += along; along = 0; }
+    len = std::min(len, lim + 1 - along);
+    if (len <= 0) return;
+    if (len == 1) { pixel(x, y, 255); return; }
+    append(kind, x, y, len, 255);
+}
+
+int raster::CommandBuffer::play_front(Framebuffer& fb, BlendMode mode)
+{
+    const DrawCommand& cmd = m_cmds[m_read++];
+    return play(fb, cmd, m_palette[cmd.color], mode);
+}
+
+int raster::CommandBuffer::play_front(TiledFramebuffer& fb, BlendMode mode)
+{
+    const DrawCommand& cmd = m_cmds[m_read++];
+    return play(fb, cmd, m_palette[cmd.color], mode);
+}
+
+void raster::CommandBuffer::clear()
+{
+    m_cmds.clear();
+    m_read = 0;
+    m_palette.clear();
+    m_color = 0;
+}
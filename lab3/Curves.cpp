@@ -0,0 +1,634 @@
+#include "rastercurve.hpp"
+#include "rastergen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    // Больше частей на кривую не бывает нужно: ограничение защищает от огромных координат
+    const int MAX_PARTS = 1 << 16;
+
+    /**
+     * @brief Шаги 1..k_last отрезка Брезенхема (шаг 0 - начало отрезка, уже выданное
+     * как конец предыдущего; шаг max(|dx|, |dy|) - конец).
+     * Пиксели те же, что у bresenham_line: шаги по второй оси в замкнутой форме
+     * из bresenham_line_clipped, серии вдоль основной оси выдаются целиком.
+     */
+    void line_steps(raster::PixelSink& sink, int x1, int y1, int x2, int y2, int k_last)
+    {
+        int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
+        bool x_major = dx >= dy;
+        int64_t d_maj = x_major ? dx : dy, d_min = x_major ? dy : dx;
+        int s_maj = x_major ? ((x1 < x2) ? 1 : -1) : ((y1 < y2) ? 1 : -1);
+        int s_min = x_major ? ((y1 < y2) ? 1 : -1) : ((x1 < x2) ? 1 : -1);
+        int maj = x_major ? x1 : y1, mn = x_major ? y1 : x1;
+        raster::SpanKind kind = x_major ? raster::SPAN_HORIZONTAL : raster::SPAN_VERTICAL;
+
+        // e = 2*d_min*k + d_maj - 1 - 2*d_maj*f(k); переход с шага 0 на шаг 1
+        int64_t e = d_maj - 1 + 2 * d_min;
+        if (e >= 2 * d_maj) { e -= 2 * d_maj; mn += s_min; }
+        maj += s_maj;
+
+        int run_start = maj;
+        for (int k = 1; k <= k_last; ++k) {
+            e += 2 * d_min;
+            bool step_min = e >= 2 * d_maj;
+            if (k == k_last || step_min) {
+                // Серия вдоль основной оси закончилась на шаге k
+                int a = std::min(run_start, maj), len = std::abs(maj - run_start) + 1;
+                if (len == 1) {
+                    if (x_major) sink.pixel(maj, mn, 255); else sink.pixel(mn, maj, 255);
+                } else {
+                    if (x_major) sink.span(kind, a, mn, len); else sink.span(kind, mn, a, len);
+                }
+                run_start = maj + s_maj;
+            }
+            if (step_min) { e -= 2 * d_maj; mn += s_min; }
+            maj += s_maj;
+        }
+    }
+
+    /**
+     * @brief line_steps, отсеченный прямоугольником. Шаг k лежит на основной оси в
+     * start + s_maj * k, поэтому шаги 1..k_last - это clip, суженный по основной оси,
+     * и дальше работает bresenham_line_clipped с той же ошибкой. Хорда целиком
+     * внутри clip рисуется без отсечения, целиком снаружи - пропускается.
+     */
+    void line_steps_clipped(raster::PixelSink& sink, int x1, int y1, int x2, int y2, int k_last,
+                            const raster::ClipRect& clip)
+    {
+        int bx0 = std::min(x1, x2), bx1 = std::max(x1, x2), by0 = std::min(y1, y2), by1 = std::max(y1, y2);
+        if (bx1 < clip.x0 || bx0 > clip.x1 || by1 < clip.y0 || by0 > clip.y1) return;
+        if (bx0 >= clip.x0 && bx1 <= clip.x1 && by0 >= clip.y0 && by1 <= clip.y1) {
+            line_steps(sink, x1, y1, x2, y2, k_last);
+            return;
+        }
+
+        raster::ClipRect c = clip;
+        bool x_major = std::abs(x2 - x1) >= std::abs(y2 - y1);
+        int start = x_major ? x1 : y1, s_maj = (x_major ? x1 < x2 : y1 < y2) ? 1 : -1;
+        int first = start + s_maj, last = start + s_maj * k_last;
+        int& lo = x_major ? c.x0 : c.y0;
+        int& hi = x_major ? c.x1 : c.y1;
+        lo = std::max(lo, std::min(first, last));
+        hi = std::min(hi, std::max(first, last));
+        raster::bresenham_line_clipped(sink, x1, y1, x2, y2, c);
+    }
+
+    /**
+     * @brief Число частей, при котором хорды отходят от кривой не больше tolerance:
+     * отклонение хорды не превышает max|B''| / (8 n^2).
+     */
+    int parts_for(double second_diff, double factor, double tolerance)
+    {
+        double n = std::ceil(std::sqrt(second_diff * factor / (8 * tolerance)));
+        if (!(n >= 1)) return 1; // и NaN
+        return (int)std::min<double>(n, MAX_PARTS);
+    }
+
+    // Квадратичная: B'' = 2 (p0 - 2 p1 + p2), прямые разности второго порядка
+    void flatten_quad(raster::PointD p0, raster::PointD p1, raster::PointD p2, double tolerance,
+                      std::vector<raster::PointD>& out)
+    {
+        double ax = p0.x - 2 * p1.x + p2.x, ay = p0.y - 2 * p1.y + p2.y;
+        int n = parts_for(std::sqrt(ax * ax + ay * ay), 2, tolerance);
+        double h = 1.0 / n;
+        double x = p0.x, y = p0.y;
+        double dx = 2 * (p1.x - p0.x) * h + ax * h * h, dy = 2 * (p1.y - p0.y) * h + ay * h * h;
+        double ddx = 2 * ax * h * h, ddy = 2 * ay * h * h;
+
+        size_t base = out.size();
+        out.resize(base + n);
+        raster::PointD* o = out.data() + base;
+        for (int i = 1; i < n; ++i) {
+            x += dx; y += dy;
+            dx += ddx; dy += ddy;
+            *o++ = {x, y};
+        }
+        *o = p2; // конец точно, без накопленной ошибки
+    }
+
+    // Кубическая: |B''| <= 6 max(|p0 - 2 p1 + p2|, |p1 - 2 p2 + p3|), прямые разности третьего порядка
+    void flatten_cubic(raster::PointD p0, raster::PointD p1, raster::PointD p2, raster::PointD p3, double tolerance,
+                       std::vector<raster::PointD>& out)
+    {
+        double ux = p0.x - 2 * p1.x + p2.x, uy = p0.y - 2 * p1.y + p2.y;
+        double vx = p1.x - 2 * p2.x + p3.x, vy = p1.y - 2 * p2.y + p3.y;
+        int n = parts_for(std::sqrt(std::max(ux * ux + uy * uy, vx * vx + vy * vy)), 6, tolerance);
+        double h = 1.0 / n, h2 = h * h, h3 = h2 * h;
+
+        // B(t) = a t^3 + b t^2 + c t + p0
+        double ax = p3.x - p0.x + 3 * (p1.x - p2.x), ay = p3.y - p0.y + 3 * (p1.y - p2.y);
+        double bx = 3 * ux, by = 3 * uy;
+        double cx = 3 * (p1.x - p0.x), cy = 3 * (p1.y - p0.y);
+
+        double x = p0.x, y = p0.y;
+        double dx = ax * h3 + bx * h2 + cx * h, dy = ay * h3 + by * h2 + cy * h;
+        double ddx = 6 * ax * h3 + 2 * bx * h2, ddy = 6 * ay * h3 + 2 * by * h2;
+        double dddx = 6 * ax * h3, dddy = 6 * ay * h3;
+
+        size_t base = out.size();
+        out.resize(base + n);
+        raster::PointD* o = out.data() + base;
+        for (int i = 1; i < n; ++i) {
+            x += dx; y += dy;
+            dx += ddx; dy += ddy;
+            ddx += dddx; ddy += dddy;
+            *o++ = {x, y};
+        }
+        *o = p3;
+    }
+
+    // Пиксель, в который попадает точка (половины - в сторону +бесконечности).
+    // Координаты ограничены, чтобы разности и ошибки Брезенхема не переполнялись.
+    inline int to_pixel(double v)
+    {
+        const double LIMIT = 1 << 28;
+        return (int)std::floor(std::clamp(v, -LIMIT, LIMIT) + 0.5);
+    }
+
+    // Сколько предыдущих монотонных участков подконтура проверяется на повторы:
+    // у квадратичной кривой их не больше 3, у кубической - не больше 5, так что
+    // окно покрывает несколько соседних кривых пути
+    const size_t REPEAT_PIECES = 16;
+
+    /**
+     * @brief Отсев пикселей, уже выданных подконтуром. Ломаная делится на участки,
+     * монотонные по обеим осям: на таком участке каждый шаг Брезенхема увеличивает
+     * t = sx * x + sy * y, поэтому внутри участка повторов нет. Хорда, чья рамка задевает
+     * рамку одного из REPEAT_PIECES предыдущих участков, выдается через фильтр: пиксель
+     * ищется в участке двоичным поиском по t и проверяется по замкнутой форме Брезенхема.
+     * Остальные хорды (почти все) идут в приемник напрямую.
+     */
+    class RepeatFilter : public raster::PixelSink
+    {
+    public:
+        // Первая точка подконтура
+        void begin(int x, int y)
+        {
+            m_points.clear();
+            m_pieces.clear();
+            m_points.push_back({x, y});
+            m_pieces.push_back({0, 0, 0, 0, x, y, x, y});
+        }
+
+        // Хорда из последней точки в (x, y); true - ее пиксели надо выдавать через through()
+        bool add_chord(int x, int y)
+        {
+            Vertex p = m_points.back();
+            int sx = (x > p.x) - (x < p.x), sy = (y > p.y) - (y < p.y);
+            Piece* cur = &m_pieces.back();
+            if ((sx && cur->sx && sx != cur->sx) || (sy && cur->sy && sy != cur->sy)) {
+                // Поворот: новый участок начинается в точке стыка
+                uint32_t joint = (uint32_t)m_points.size() - 1;
+                m_pieces.push_back({joint, joint, 0, 0, p.x, p.y, p.x, p.y});
+                cur = &m_pieces.back();
+            }
+            if (sx) cur->sx = sx;
+            if (sy) cur->sy = sy;
+            m_points.push_back({x, y});
+            cur->last = (uint32_t)m_points.size() - 1;
+            cur->x0 = std::min(cur->x0, x); cur->x1 = std::max(cur->x1, x);
+            cur->y0 = std::min(cur->y0, y); cur->y1 = std::max(cur->y1, y);
+
+            size_t n = m_pieces.size() - 1;
+            m_count = 0;
+            if (n == 0) return false;
+            // Рамка шагов 1..k_last: без точки стыка, иначе предыдущий участок задевался бы всегда
+            Vertex s1 = step_one(p, {x, y});
+            int bx0 = std::min(x, s1.x), bx1 = std::max(x, s1.x), by0 = std::min(y, s1.y), by1 = std::max(y, s1.y);
+            for (size_t i = (n > REPEAT_PIECES) ? n - REPEAT_PIECES : 0; i < n; ++i) {
+                const Piece& q = m_pieces[i];
+                if (q.x0 <= bx1 && bx0 <= q.x1 && q.y0 <= by1 && by0 <= q.y1) m_candidates[m_count++] = i;
+            }
+            return m_count > 0;
+        }
+
+        // Фильтр, выдающий в sink только новые пиксели
+        raster::PixelSink& through(raster::PixelSink& sink)
+        {
+            m_sink = &sink;
+            return *this;
+        }
+
+        void pixel(int x, int y, uint8_t alpha) override
+        {
+            if (!seen(x, y)) m_sink->pixel(x, y, alpha);
+        }
+
+        void span(raster::SpanKind kind, int x, int y, int len) override
+        {
+            // Серия режется на куски из еще не выданных пикселей
+            bool horizontal = kind == raster::SPAN_HORIZONTAL;
+            int run = 0;
+            for (int i = 0; i <= len; ++i) {
+                if (i < len && !seen(horizontal ? x + i : x, horizontal ? y : y + i)) {
+                    ++run;
+                    continue;
+                }
+                if (run == 1) {
+                    if (horizontal) m_sink->pixel(x + i - 1, y, 255); else m_sink->pixel(x, y + i - 1, 255);
+                } else if (run > 1) {
+                    if (horizontal) m_sink->span(kind, x + i - run, y, run); else m_sink->span(kind, x, y + i - run, run);
+                }
+                run = 0;
+            }
+        }
+
+    private:
+        struct Vertex
+        {
+            int x, y;
+        };
+
+        /**
+         * @brief Монотонный участок: хорды points[first..last], направление (sx, sy)
+         * (0 - по этой оси участок не двигался) и рамка пикселей.
+         */
+        struct Piece
+        {
+            uint32_t first, last;
+            int sx, sy;
+            int x0, y0, x1, y1;
+        };
+
+        bool seen(int x, int y) const
+        {
+            for (int i = 0; i < m_count; ++i) {
+                const Piece& q = m_pieces[m_candidates[i]];
+                if (x >= q.x0 && x <= q.x1 && y >= q.y0 && y <= q.y1 && on_piece(q, x, y)) return true;
+            }
+            return false;
+        }
+
+        bool on_piece(const Piece& q, int x, int y) const
+        {
+            auto t = [&](const Vertex& v) { return (int64_t)q.sx * v.x + (int64_t)q.sy * v.y; };
+            int64_t tp = (int64_t)q.sx * x + (int64_t)q.sy * y;
+            if (tp < t(m_points[q.first]) || tp > t(m_points[q.last])) return false;
+            // Первая хорда, чей конец не раньше пикселя по t
+            uint32_t lo = q.first + 1, hi = q.last;
+            while (lo < hi) {
+                uint32_t mid = lo + (hi - lo) / 2;
+                if (t(m_points[mid]) >= tp) hi = mid; else lo = mid + 1;
+            }
+            return on_chord(m_points[lo - 1], m_points[lo], x, y);
+        }
+
+        // Шаг 1 хорды a -> b (см. on_chord)
+        static Vertex step_one(const Vertex& a, const Vertex& b)
+        {
+            int64_t dx = std::abs((int64_t)b.x - a.x), dy = std::abs((int64_t)b.y - a.y);
+            bool x_major = dx >= dy;
+            int64_t d_maj = x_major ? dx : dy, d_min = x_major ? dy : dx;
+            int f = (2 * d_min + d_maj - 1 >= 2 * d_maj) ? 1 : 0;
+            int sx = (b.x > a.x) - (b.x < a.x), sy = (b.y > a.y) - (b.y < a.y);
+            return x_major ? Vertex{a.x + sx, a.y + sy * f} : Vertex{a.x + sx * f, a.y + sy};
+        }
+
+        // Шаг k хорды a -> b у line_steps: по второй оси floor((2 d_min k + d_maj - 1) / (2 d_maj))
+        static bool on_chord(const Vertex& a, const Vertex& b, int x, int y)
+        {
+            int64_t dx = std::abs((int64_t)b.x - a.x), dy = std::abs((int64_t)b.y - a.y);
+            bool x_major = dx >= dy;
+            int64_t d_maj = x_major ? dx : dy, d_min = x_major ? dy : dx;
+            int64_t k = x_major ? ((int64_t)x - a.x) * ((a.x < b.x) ? 1 : -1) : ((int64_t)y - a.y) * ((a.y < b.y) ? 1 : -1);
+            if (k < 0 || k > d_maj) return false;
+            int64_t f = (2 * d_min * k + d_maj - 1) / (2 * d_maj);
+            if (x_major) return y == a.y + ((a.y < b.y) ? f : -f);
+            return x == a.x + ((a.x < b.x) ? f : -f);
+        }
+
+        std::vector<Vertex> m_points;
+        std::vector<Piece> m_pieces;
+        size_t m_candidates[REPEAT_PIECES];
+        int m_count = 0;
+        raster::PixelSink* m_sink = nullptr;
+    };
+
+    /**
+     * @brief Обход ломаных в пикселях: start(x, y) - первая точка подконтура,
+     * steps(out, x1, y1, x2, y2, k_last) - шаги 1..k_last отрезка в приемник out
+     * (sink или фильтр повторов). Точки стыков не выдаются дважды, пиксели, уже
+     * выданные подконтуром, отсеивает RepeatFilter.
+     */
+    template <class Start, class Steps>
+    void walk_polyline(raster::PixelSink& sink, const raster::Polyline& lines, Start&& start, Steps&& steps)
+    {
+        thread_local RepeatFilter tls_repeats;
+        RepeatFilter& repeats = tls_repeats;
+        auto chord = [&](int x1, int y1, int x2, int y2, int k_last) {
+            bool filtered = repeats.add_chord(x2, y2);
+            steps(filtered ? repeats.through(sink) : sink, x1, y1, x2, y2, k_last);
+        };
+        for (size_t c = 0; c < lines.contours(); ++c) {
+            uint32_t first = lines.starts[c], last = lines.end(c);
+            int px = to_pixel(lines.points[first].x), py = to_pixel(lines.points[first].y);
+            int x0 = px, y0 = py;
+            start(px, py);
+            repeats.begin(px, py);
+            for (uint32_t i = first + 1; i < last; ++i) {
+                int x = to_pixel(lines.points[i].x), y = to_pixel(lines.points[i].y);
+                if (x == px && y == py) continue;
+                int n = std::max(std::abs(x - px), std::abs(y - py));
+                chord(px, py, x, y, n);
+                px = x;
+                py = y;
+            }
+            // Замыкающий отрезок без обоих концов: они уже выданы
+            int n = std::max(std::abs(x0 - px), std::abs(y0 - py));
+            if (lines.closed[c] && n > 1) chord(px, py, x0, y0, n - 1);
+        }
+    }
+
+    /**
+     * @brief Ломаные в том же порядке, что walk_polyline + line_steps_clipped, но с
+     * остановкой после каждой порции: состояние - подконтур, точка и шаг текущей хорды.
+     * Длинная хорда выдается полосами по CHUNK шагов основной оси, только в пределах
+     * clip по этой оси; хорда с рамкой мимо clip пропускается без порций.
+     */
+    class PolylineGenerator : public raster::PrimitiveGenerator
+    {
+    public:
+        PolylineGenerator(raster::Polyline lines, const raster::ClipRect& clip)
+            : m_lines(std::move(lines)), m_clip(clip)
+        {
+            if (clip.empty()) m_contour = m_lines.contours();
+        }
+
+        bool next(raster::PixelSink& sink) override
+        {
+            for (;;) {
+                if (m_k <= m_k_last) {
+                    chord_band(sink);
+                    return true;
+                }
+                if (m_contour >= m_lines.contours()) return false;
+
+                uint32_t last = m_lines.end(m_contour);
+                if (m_point == 0) {
+                    // Первая точка подконтура
+                    uint32_t first = m_lines.starts[m_contour];
+                    if (first >= last) { ++m_contour; continue; }
+                    m_px = m_x0 = to_pixel(m_lines.points[first].x);
+                    m_py = m_y0 = to_pixel(m_lines.points[first].y);
+                    m_point = first + 1;
+                    m_closing = false;
+                    m_repeats.begin(m_px, m_py);
+                    if (m_clip.contains(m_px, m_py)) sink.pixel(m_px, m_py, 255);
+                    return true;
+                }
+                if (m_point < last) {
+                    int x = to_pixel(m_lines.points[m_point].x), y = to_pixel(m_lines.points[m_point].y);
+                    ++m_point;
+                    if (x == m_px && y == m_py) continue;
+                    start_chord(x, y, std::max(std::abs(x - m_px), std::abs(y - m_py)));
+                    continue;
+                }
+                if (!m_closing) {
+                    // Замыкающий отрезок без обоих концов
+                    m_closing = true;
+                    int n = std::max(std::abs(m_x0 - m_px), std::abs(m_y0 - m_py));
+                    if (m_lines.closed[m_contour] && n > 1) start_chord(m_x0, m_y0, n - 1);
+                    continue;
+                }
+                ++m_contour;
+                m_point = 0;
+            }
+        }
+
+    private:
+        void start_chord(int x, int y, int k_last)
+        {
+            m_qx = x;
+            m_qy = y;
+            m_filtered = m_repeats.add_chord(x, y);
+
+            // Как в LineGenerator: шаги вне clip по основной оси не обходятся, хорда
+            // с рамкой мимо clip пропускается целиком
+            bool x_major = std::abs(x - m_px) >= std::abs(y - m_py);
+            int start = x_major ? m_px : m_py, s_maj = (x_major ? m_px < x : m_py < y) ? 1 : -1;
+            int lo = x_major ? m_clip.x0 : m_clip.y0, hi = x_major ? m_clip.x1 : m_clip.y1;
+            int64_t k0 = std::max<int64_t>(1, (s_maj > 0) ? (int64_t)lo - start : (int64_t)start - hi);
+            int64_t k1 = std::min<int64_t>(k_last, (s_maj > 0) ? (int64_t)hi - start : (int64_t)start - lo);
+            if (std::max(x, m_px) < m_clip.x0 || std::min(x, m_px) > m_clip.x1 ||
+                std::max(y, m_py) < m_clip.y0 || std::min(y, m_py) > m_clip.y1)
+                k0 = k1 + 1;
+            m_k = (int)std::min<int64_t>(k0, (int64_t)k_last + 1);
+            m_k_last = (int)std::max<int64_t>(k1, 0);
+            if (m_k > m_k_last) finish_chord();
+        }
+
+        // Хорда выдана: следующая начинается из ее конца (замыкающая - последняя в подконтуре)
+        void finish_chord()
+        {
+            if (m_closing) return;
+            m_px = m_qx;
+            m_py = m_qy;
+        }
+
+        // Шаги [m_k, m_k + CHUNK) хорды: clip, суженный по основной оси, и line_steps_clipped
+        void chord_band(raster::PixelSink& sink)
+        {
+            int k1 = std::min(m_k + CHUNK - 1, m_k_last);
+            bool x_major = std::abs(m_qx - m_px) >= std::abs(m_qy - m_py);
+            int start = x_major ? m_px : m_py, s_maj = (x_major ? m_px < m_qx : m_py < m_qy) ? 1 : -1;
+            int a = start + s_maj * m_k, b = start + s_maj * k1;
+            raster::ClipRect c = m_clip;
+            int& lo = x_major ? c.x0 : c.y0;
+            int& hi = x_major ? c.x1 : c.y1;
+            lo = std::max(lo, std::min(a, b));
+            hi = std::min(hi, std::max(a, b));
+            if (lo <= hi) line_steps_clipped(m_filtered ? m_repeats.through(sink) : sink, m_px, m_py, m_qx, m_qy, k1, c);
+            m_k = k1 + 1;
+            if (m_k > m_k_last) finish_chord();
+        }
+
+        raster::Polyline m_lines;
+        raster::ClipRect m_clip;
+        size_t m_contour = 0;
+        uint32_t m_point = 0;   ///< Следующая точка подконтура; 0 - подконтур не начат.
+        bool m_closing = false;
+        int m_px = 0, m_py = 0, m_x0 = 0, m_y0 = 0;
+        int m_qx = 0, m_qy = 0;  ///< Конец текущей хорды.
+        int m_k = 1, m_k_last = 0;
+        RepeatFilter m_repeats;
+        bool m_filtered = false;  ///< Текущая хорда идет через m_repeats.
+    };
+} // namespace
+
+
+void raster::Path::ensure_started()
+{
+    if (m_verbs.empty()) move_to(0, 0);
+}
+
+void raster::Path::move_to(double x, double y)
+{
+    m_verbs.push_back(MOVE);
+    m_points.push_back({x, y});
+}
+
+void raster::Path::line_to(double x, double y)
+{
+    ensure_started();
+    m_verbs.push_back(LINE);
+    m_points.push_back({x, y});
+}
+
+void raster::Path::quad_to(double cx, double cy, double x, double y)
+{
+    ensure_started();
+    m_verbs.push_back(QUAD);
+    m_points.push_back({cx, cy});
+    m_points.push_back({x, y});
+}
+
+void raster::Path::cubic_to(double c1x, double c1y, double c2x, double c2y, double x, double y)
+{
+    ensure_started();
+    m_verbs.push_back(CUBIC);
+    m_points.push_back({c1x, c1y});
+    m_points.push_back({c2x, c2y});
+    m_points.push_back({x, y});
+}
+
+void raster::Path::close()
+{
+    if (!m_verbs.empty() && m_verbs.back() != CLOSE) m_verbs.push_back(CLOSE);
+}
+
+void raster::Path::clear()
+{
+    m_verbs.clear();
+    m_points.clear();
+}
+
+void raster::flatten_path(const Path& path, double tolerance, Polyline& out)
+{
+    out.clear();
+    tolerance = std::max(tolerance, 1e-3);
+    const std::vector<PointD>& pts = path.points();
+    size_t ip = 0;
+    PointD cur = {0, 0};
+
+    for (Path::Verb verb : path.verbs()) {
+        switch (verb) {
+        case Path::MOVE:
+            cur = pts[ip++];
+            out.starts.push_back((uint32_t)out.points.size());
+            out.closed.push_back(0);
+            out.points.push_back(cur);
+            break;
+        case Path::LINE:
+            cur = pts[ip++];
+            out.points.push_back(cur);
+            break;
+        case Path::QUAD:
+            flatten_quad(cur, pts[ip], pts[ip + 1], tolerance, out.points);
+            cur = pts[ip + 1];
+            ip += 2;
+            break;
+        case Path::CUBIC:
+            flatten_cubic(cur, pts[ip], pts[ip + 1], pts[ip + 2], tolerance, out.points);
+            cur = pts[ip + 2];
+            ip += 3;
+            break;
+        case Path::CLOSE:
+            out.closed.back() = 1;
+            break;
+        }
+    }
+}
+
+void raster::draw_polyline(PixelSink& sink, const Polyline& lines)
+{
+    walk_polyline(sink, lines, [&](int x, int y) { sink.pixel(x, y, 255); },
+                  [&](raster::PixelSink& out, int x1, int y1, int x2, int y2, int k_last) {
+                      line_steps(out, x1, y1, x2, y2, k_last);
+                  });
+}
+
+void raster::draw_polyline_clipped(PixelSink& sink, const Polyline& lines, const ClipRect& clip)
+{
+    if (clip.empty()) return;
+    walk_polyline(sink, lines, [&](int x, int y) { if (clip.contains(x, y)) sink.pixel(x, y, 255); },
+                  [&](raster::PixelSink& out, int x1, int y1, int x2, int y2, int k_last) {
+                      line_steps_clipped(out, x1, y1, x2, y2, k_last, clip);
+                  });
+}
+
+void raster::draw_path(PixelSink& sink, const Path& path, double tolerance)
+{
+    // Буфер ломаных переиспользуется между вызовами: тысячи кривых за кадр без выделений
+    thread_local Polyline lines;
+    flatten_path(path, tolerance, lines);
+    draw_polyline(sink, lines);
+}
+
+void raster::draw_path_clipped(PixelSink& sink, const Path& path, const ClipRect& clip, double tolerance)
+{
+    if (clip.empty() || path.points().empty()) return;
+
+    // Кривые лежат в выпуклой оболочке контрольных точек: рамка оболочки вне clip - рисовать нечего
+    double x0 = path.points()[0].x, x1 = x0, y0 = path.points()[0].y, y1 = y0;
+    for (const PointD& p : path.points()) {
+        x0 = std::min(x0, p.x); x1 = std::max(x1, p.x);
+        y0 = std::min(y0, p.y); y1 = std::max(y1, p.y);
+    }
+    if (to_pixel(x1) < clip.x0 || to_pixel(x0) > clip.x1 || to_pixel(y1) < clip.y0 || to_pixel(y0) > clip.y1) return;
+
+    thread_local Polyline lines;
+    flatten_path(path, tolerance, lines);
+    draw_polyline_clipped(sink, lines, clip);
+}
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_polyline_generator(Polyline lines, const ClipRect& clip)
+{
+    return std::make_unique<PolylineGenerator>(std::move(lines), clip);
+}
+
+void raster::bezier_quadratic(PixelSink& sink, int x1, int y1, int cx, int cy, int x2, int y2)
+{
+    thread_local Path path;
+    path.clear();
+    path.move_to(x1, y1);
+    path.quad_to(cx, cy, x2, y2);
+    draw_path(sink, path);
+}
+
+void raster::bezier_cubic(PixelSink& sink, int x1, int y1, int c1x, int c1y, int c2x, int c2y, int x2, int y2)
+{
+    thread_local Path path;
+    path.clear();
+    path.move_to(x1, y1);
+    path.cubic_to(c1x, c1y, c2x, c2y, x2, y2);
+    draw_path(sink, path);
+}
+
+void raster::bezier_quadratic_clipped(PixelSink& sink, int x1, int y1, int cx, int cy, int x2, int y2,
+                                      const ClipRect& clip)
+{
+    thread_local Path path;
+    path.clear();
+    path.move_to(x1, y1);
+    path.quad_to(cx, cy, x2, y2);
+    draw_path_clipped(sink, path, clip);
+}
+
+void raster::bezier_cubic_clipped(PixelSink& sink, int x1, int y1, int c1x, int c1y, int c2x, int c2y, int x2, int y2,
+                                  const ClipRect& clip)
+{
+    thread_local Path path;
+    path.clear();
+    path.move_to(x1, y1);
+    path.cubic_to(c1x, c1y, c2x, c2y, x2, y2);
+    draw_path_clipped(sink, path, clip);
+}
@@ -0,0 +1,335 @@
+#include "rasterfill.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    // Подстрок на строку пикселей при сглаживании
+    const int AA_SUBROWS = 16;
+
+    /**
+     * @brief Ребро в таблице ребер: строки first..last (в единицах подстрок),
+     * x на текущей строке и приращение x на строку.
+     */
+    struct Edge
+    {
+        double x0, y0, dxdy;  ///< Верхний конец и наклон; x строки Y = x0 + (Y - y0) * dxdy.
+        double x;
+        int first, last;
+        int dir;  ///< +1 - ребро идет вниз, -1 - вверх (для правила NonZero).
+    };
+
+    /**
+     * @brief Горизонтальная серия [x0, x1] строки y, отсеченная по clip.
+     */
+    inline void clipped_span(raster::PixelSink& sink, const raster::ClipRect& clip, int64_t y, int64_t x0, int64_t x1)
+    {
+        if (y < clip.y0 || y > clip.y1) return;
+        x0 = std::max<int64_t>(x0, clip.x0);
+        x1 = std::min<int64_t>(x1, clip.x1);
+        if (x0 == x1) { sink.pixel((int)x0, (int)y, 255); return; }
+        // Строка во весь диапазон int длиннее INT_MAX - выдается частями
+        for (; x0 <= x1; x0 += INT32_MAX)
+            sink.span(raster::SPAN_HORIZONTAL, (int)x0, (int)y, (int)std::min<int64_t>(x1 - x0 + 1, INT32_MAX));
+    }
+
+    /**
+     * @brief Обходит строки row_lo..row_hi контура, растянутого по вертикали в scale раз
+     * (строка Y соответствует y = (Y + 0.5) / scale - 0.5), и для каждого интервала
+     * [xl, xr) внутри фигуры вызывает interval(Y, xl, xr). Строки идут по возрастанию.
+     */
+    template <class F>
+    void scan_edges(const raster::Polyline& lines, double scale, int row_lo, int row_hi, raster::FillRule rule,
+                    F&& interval)
+    {
+        // Таблица ребер и список активных ребер переиспользуются между вызовами
+        thread_local std::vector<Edge> edges;
+        thread_local std::vector<int> active;
+        edges.clear();
+        active.clear();
+        if (row_lo > row_hi) return;
+
+        for (size_t c = 0; c < lines.contours(); ++c) {
+            uint32_t first = lines.starts[c], last = lines.end(c);
+            if (last - first < 2) continue;
+            for (uint32_t i = first; i < last; ++i) {
+                const raster::PointD& a = lines.points[i];
+                const raster::PointD& b = lines.points[(i + 1 < last) ? i + 1 : first]; // подконтур замкнут
+                double ya = (a.y + 0.5) * scale - 0.5, yb = (b.y + 0.5) * scale - 0.5;
+                if (!(ya != yb) || !std::isfinite(a.x) || !std::isfinite(b.x)) continue; // горизонтальное или NaN
+                int dir = (yb > ya) ? 1 : -1;
+                double xt = (dir > 0) ? a.x : b.x, yt = std::min(ya, yb), yd = std::max(ya, yb);
+                double xd = (dir > 0) ? b.x : a.x;
+
+                // Строки Y с yt <= Y < yd: верхний конец включительно, нижний - нет
+                double f = std::max(std::ceil(yt), (double)row_lo);
+                double l = std::min(std::ceil(yd) - 1, (double)row_hi);
+                if (f > l) continue;
+                double dxdy = (xd - xt) / (yd - yt);
+                edges.push_back({xt, yt, dxdy, 0.0, (int)f, (int)l, dir});
+            }
+        }
+        if (edges.empty()) return;
+        std::sort(edges.begin(), edges.end(), [](const Edge& p, const Edge& q) { return p.first < q.first; });
+
+        size_t next = 0;
+        int row = edges[0].first;
+        while (row <= row_hi) {
+            while (next < edges.size() && edges[next].first == row) active.push_back((int)next++);
+            active.erase(std::remove_if(active.begin(), active.end(), [&](int e) { return edges[e].last < row; }),
+                         active.end());
+            if (active.empty()) {
+                if (next == edges.size()) break;
+                row = edges[next].first; // пропуск пустых строк между подконтурами
+                continue;
+            }
+
+            // x считается от верхнего конца, а не накоплением, чтобы ошибка не росла по длине ребра
+            for (int e : active) edges[e].x = edges[e].x0 + (row - edges[e].y0) * edges[e].dxdy;
+
+            // Порядок по x между строками почти не меняется: сортировка вставками
+            for (size_t i = 1; i < active.size(); ++i) {
+                int e = active[i];
+                size_t j = i;
+                for (; j > 0 && edges[active[j - 1]].x > edges[e].x; --j) active[j] = active[j - 1];
+                active[j] = e;
+            }
+
+            int winding = 0;
+            double xl = 0;
+            for (int e : active) {
+                int before = winding;
+                winding = (rule == raster::FillRule::EvenOdd) ? (winding ^ 1) : winding + edges[e].dir;
+                if (before == 0 && winding != 0) xl = edges[e].x;
+                else if (before != 0 && winding == 0 && edges[e].x > xl) interval(row, xl, edges[e].x);
+            }
+
+            ++row;
+        }
+    }
+
+    /**
+     * @brief Покрытие одной строки пикселей при сглаживании: доли площади краевых
+     * пикселей и разностный массив полностью закрытых, поэтому интервал подстроки
+     * стоит O(1) независимо от длины. Строка - столбцы [x0, x0 + width); массивы
+     * переиспользуются между вызовами и между строками остаются нулевыми (flush
+     * обнуляет все, что заполнил add).
+     */
+    class CoverageRow
+    {
+    public:
+        void begin(raster::PixelSink& sink, int x0, int width)
+        {
+            m_sink = &sink;
+            m_x0 = x0;
+            m_width = width;
+            if (m_area.size() < (size_t)width + 1) {
+                m_area.resize((size_t)width + 1, 0.0f);
+                m_full.resize((size_t)width + 1, 0.0f);
+            }
+            m_lo = width;
+            m_hi = -1;
+        }
+
+        // Интервал [xl, xr) одной подстроки; пиксель x занимает [x - 0.5, x + 0.5)
+        void add(double xl, double xr)
+        {
+            double u0 = std::clamp(xl + 0.5 - m_x0, 0.0, (double)m_width);
+            double u1 = std::clamp(xr + 0.5 - m_x0, 0.0, (double)m_width);
+            if (u0 >= u1) return;
+            const float w = 1.0f / AA_SUBROWS;
+            int i0 = (int)u0, i1 = (int)u1;
+            if (i0 == i1) {
+                m_area[i0] += (float)(u1 - u0) * w;
+            } else {
+                m_area[i0] += (float)(i0 + 1 - u0) * w;
+                m_full[i0 + 1] += w;
+                m_full[i1] -= w;
+                m_area[i1] += (float)(u1 - i1) * w;
+            }
+            m_lo = std::min(m_lo, i0);
+            m_hi = std::max(m_hi, i1);
+        }
+
+        // Выдает строку y: полностью закрытые пиксели - сериями, краевые - с покрытием
+        void flush(int y)
+        {
+            float full = 0;
+            int run = -1;
+            int hi = std::min(m_hi, m_width - 1);
+            for (int i = m_lo; i <= hi; ++i) {
+                full += m_full[i];
+                float c = std::min(1.0f, full + m_area[i]);
+                int alpha = (int)(c * 255 + 0.5f);
+                m_full[i] = m_area[i] = 0;
+                if (alpha == 255) {
+                    if (run < 0) run = i;
+                    continue;
+                }
+                if (run >= 0) { emit_run(run, i - 1, y); run = -1; }
+                if (alpha > 0) m_sink->pixel(m_x0 + i, y, (uint8_t)alpha);
+            }
+            if (run >= 0) emit_run(run, hi, y);
+            if (m_hi >= m_width) m_full[m_width] = m_area[m_width] = 0;
+            m_lo = m_width;
+            m_hi = -1;
+        }
+
+    private:
+        void emit_run(int a, int b, int y)
+        {
+            if (a == b) m_sink->pixel(m_x0 + a, y, 255);
+            else m_sink->span(raster::SPAN_HORIZONTAL, m_x0 + a, y, b - a + 1);
+        }
+
+        raster::PixelSink* m_sink = nullptr;
+        int m_x0 = 0, m_width = 0;
+        int m_lo = 0, m_hi = -1;
+        std::vector<float> m_area, m_full;
+    };
+
+    inline int floor_div(int a, int b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+
+    /**
+     * @brief Полуширина строки k эллипса с полуосями rx, ry (0 <= k <= ry): наибольший x
+     * с центром пикселя внутри, x^2 * ry^2 + k^2 * rx^2 <= rx^2 * ry^2.
+     * Произведения до 2^124 считаются в unsigned __int128.
+     */
+    inline int64_t ellipse_half_width(int64_t rx, int64_t ry, int64_t k)
+    {
+        if (ry == 0) return rx;
+        using u128 = unsigned __int128;
+        // floor(sqrt(floor(q))) == floor(sqrt(q)), а q = rx^2 * (ry^2 - k^2) / ry^2 <= rx^2 < 2^62
+        uint64_t q = (uint64_t)((u128)(rx * rx) * (u128)(ry * ry - k * k) / (u128)(ry * ry));
+        uint64_t w = (uint64_t)std::sqrt((double)q);
+        while (w * w > q) --w;
+        while ((w + 1) * (w + 1) <= q) ++w;
+        return (int64_t)w;
+    }
+} // namespace
+
+
+void raster::fill_polyline(PixelSink& sink, const Polyline& lines, FillRule rule, const ClipRect& clip, bool antialias)
+{
+    if (clip.empty()) return;
+
+    if (!antialias) {
+        scan_edges(lines, 1.0, clip.y0, clip.y1, rule, [&](int y, double xl, double xr) {
+            // Центр пикселя x внутри, если xl <= x < xr
+            xl = std::max(xl, clip.x0 - 1.0);
+            xr = std::min(xr, clip.x1 + 1.0);
+            clipped_span(sink, clip, y, (int)std::ceil(xl), (int)std::ceil(xr) - 1);
+        });
+        return;
+    }
+
+    // Строка покрытия и обход строк - clip, суженный до рамки контура (с запасом в пиксель на край)
+    double min_x = INFINITY, max_x = -INFINITY, min_y = INFINITY, max_y = -INFINITY;
+    for (const PointD& p : lines.points) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y)) continue;
+        min_x = std::min(min_x, p.x);
+        max_x = std::max(max_x, p.x);
+        min_y = std::min(min_y, p.y);
+        max_y = std::max(max_y, p.y);
+    }
+    if (!(min_x <= max_x)) return;
+    int64_t x0 = std::max<int64_t>(clip.x0, (int64_t)std::floor(std::max(min_x, -4e9)) - 1);
+    int64_t x1 = std::min<int64_t>(clip.x1, (int64_t)std::ceil(std::min(max_x, 4e9)) + 1);
+    int64_t y0 = std::max<int64_t>(clip.y0, (int64_t)std::floor(std::max(min_y, -4e9)) - 1);
+    int64_t y1 = std::min<int64_t>(clip.y1, (int64_t)std::ceil(std::min(max_y, 4e9)) + 1);
+    if (x0 > x1 || y0 > y1) return;
+    // Индексы строки - int; контур шире 2^31 пикселей потребовал бы массивов больше 16 ГБ
+    if (x1 - x0 + 1 >= INT32_MAX) return;
+
+    thread_local CoverageRow row;
+    row.begin(sink, (int)x0, (int)(x1 - x0 + 1));
+    int current = 0;
+    bool pending = false;
+    // Видимые строки в подстроках; на границах clip подстроки ограничены самим clip.
+    // Номер подстроки - int: строки дальше 2^27 от начала координат не выдаются
+    int64_t lo = std::max<int64_t>(y0 * AA_SUBROWS, INT32_MIN);
+    int64_t hi = std::min<int64_t>(y1 * AA_SUBROWS + AA_SUBROWS - 1, INT32_MAX);
+    if (lo > hi) return;
+    scan_edges(lines, AA_SUBROWS, (int)lo, (int)hi, rule, [&](int sub, double xl, double xr) {
+        int y = floor_div(sub, AA_SUBROWS);
+        if (pending && y != current) row.flush(current);
+        current = y;
+        pending = true;
+        row.add(xl, xr);
+    });
+    if (pending) row.flush(current);
+}
+
+void raster::fill_polygon(PixelSink& sink, const PointD* points, size_t count, FillRule rule, const ClipRect& clip,
+                          bool antialias)
+{
+    thread_local Polyline lines;
+    lines.clear();
+    lines.points.assign(points, points + count);
+    lines.starts.push_back(0);
+    lines.closed.push_back(1);
+    fill_polyline(sink, lines, rule, clip, antialias);
+}
+
+void raster::fill_path(PixelSink& sink, const Path& path, FillRule rule, const ClipRect& clip, bool antialias,
+                       double tolerance)
+{
+    thread_local Polyline lines;
+    flatten_path(path, tolerance, lines);
+    fill_polyline(sink, lines, rule, clip, antialias);
+}
+
+void raster::fill_circle(PixelSink& sink, int cx, int cy, int radius, const ClipRect& clip)
+{
+    if (radius < 0 || clip.empty()) return;
+
+    // Полуширина строки k - самый дальний по x пиксель окружности bresenham_circle в этой строке.
+    // Точка октанта (x, y) дает строку y шириной x и симметричную строку x шириной y;
+    // y точки считается напрямую, поэтому обходятся только строки внутри clip.
+    int x_end = bresenham_circle_octant_end(radius);
+    int y_end = bresenham_circle_y(radius, x_end);
+    auto half = [&](int k) {
+        int w = (k <= x_end) ? bresenham_circle_y(radius, k) : -1;
+        if (k >= y_end) {
+            // Последний x октанта с y >= k; y убывает не больше чем на 1, поэтому y там ровно k
+            int lo = 0, hi = x_end;
+            while (lo < hi) {
+                int mid = lo + (hi - lo + 1) / 2;
+                if (bresenham_circle_y(radius, mid) >= k) lo = mid; else hi = mid - 1;
+            }
+            w = std::max(w, lo);
+        }
+        return w;
+    };
+
+    // Строки cy + k или cy - k внутри clip
+    int64_t k_lo = std::max<int64_t>({0, (int64_t)clip.y0 - cy, (int64_t)cy - clip.y1});
+    if (cy >= clip.y0 && cy <= clip.y1) k_lo = 0;
+    int64_t k_hi = std::min<int64_t>(radius, std::max((int64_t)clip.y1 - cy, (int64_t)cy - clip.y0));
+    for (int64_t k = k_lo; k <= k_hi; ++k) {
+        int w = half((int)k);
+        clipped_span(sink, clip, cy + k, (int64_t)cx - w, (int64_t)cx + w);
+        if (k) clipped_span(sink, clip, cy - k, (int64_t)cx - w, (int64_t)cx + w);
+    }
+}
+
+void raster::fill_ellipse(PixelSink& sink, int cx, int cy, int rx, int ry, const ClipRect& clip)
+{
+    if (rx < 0 || ry < 0 || clip.empty()) return;
+
+    // Строки cy + k или cy - k внутри clip, как в fill_circle
+    int64_t k_lo = std::max<int64_t>({0, (int64_t)clip.y0 - cy, (int64_t)cy - clip.y1});
+    if (cy >= clip.y0 && cy <= clip.y1) k_lo = 0;
+    int64_t k_hi = std::min<int64_t>(ry, std::max((int64_t)clip.y1 - cy, (int64_t)cy - clip.y0));
+    for (int64_t k = k_lo; k <= k_hi; ++k) {
+        int64_t w = ellipse_half_width(rx, ry, k);
+        clipped_span(sink, clip, cy + k, (int64_t)cx - w, (int64_t)cx + w);
+        if (k) clipped_span(sink, clip, cy - k, (int64_t)cx - w, (int64_t)cx + w);
+    }
+}
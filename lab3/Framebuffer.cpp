@@ -0,0 +1,323 @@
+#include "rasterlib.hpp"
+#include "rastersimd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    /**
+     * @brief Таблицы перевода sRGB 8 бит <-> линейная яркость 12 бит.
+     * 12 бит хватает, чтобы темные оттенки sRGB не склеивались после обратного перевода.
+     */
+    struct GammaTables
+    {
+        static constexpr int LINEAR_MAX = 4095;
+        uint16_t to_linear[256];
+        uint8_t to_srgb[LINEAR_MAX + 1];
+
+        GammaTables()
+        {
+            for (int i = 0; i < 256; ++i) {
+                double c = i / 255.0;
+                double l = (c <= 0.04045) ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+                to_linear[i] = (uint16_t)std::lround(l * LINEAR_MAX);
+            }
+            for (int i = 0; i <= LINEAR_MAX; ++i) {
+                double l = (double)i / LINEAR_MAX;
+                double c = (l <= 0.0031308) ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+                to_srgb[i] = (uint8_t)std::lround(std::clamp(c, 0.0, 1.0) * 255);
+            }
+        }
+    };
+
+    const GammaTables g_gamma;
+
+    /**
+     * @brief Источник в линейной яркости (B, G, R - порядок байтов буфера).
+     */
+    struct LinearColor
+    {
+        int b, g, r;
+
+        explicit LinearColor(raster::Rgba8 c)
+            : b(g_gamma.to_linear[c.b]), g(g_gamma.to_linear[c.g]), r(g_gamma.to_linear[c.r]) {}
+    };
+
+    /**
+     * @brief Один канал: dst + (src - dst) * coverage / 255 в линейной яркости.
+     */
+    inline uint8_t mix_linear(uint8_t dst, int src_linear, int coverage)
+    {
+        int d = g_gamma.to_linear[dst];
+        int t = (src_linear - d) * coverage;
+        return g_gamma.to_srgb[d + (t + (t >= 0 ? 127 : -127)) / 255];
+    }
+
+    /**
+     * @brief Смешивает один пиксель BGRA по покрытию.
+     */
+    inline void mix_pixel(uint8_t* p, const LinearColor& src, int coverage)
+    {
+        p[0] = mix_linear(p[0], src.b, coverage);
+        p[1] = mix_linear(p[1], src.g, coverage);
+        p[2] = mix_linear(p[2], src.r, coverage);
+        p[3] = 255;
+    }
+} // namespace
+
+
+raster::Framebuffer::Framebuffer(int width, int height)
+{
+    resize(width, height);
+}
+
+void raster::Framebuffer::resize(int width, int height)
+{
+    m_width = std::max(0, width);
+    m_height = std::max(0, height);
+    clear();
+}
+
+void raster::Framebuffer::clear()
+{
+    m_data.assign((size_t)m_width * m_height * 4, 255);
+}
+
+void raster::Framebuffer::blend(int x, int y, Rgba8 color, uint8_t coverage, BlendMode mode)
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) return;
+    simd::blend_one(&m_data[((size_t)y * m_width + x) * 4], simd::prepare_source(color, coverage, mode), mode);
+}
+
+void raster::Framebuffer::blend_span(SpanKind kind, int x, int y, int len, Rgba8 color, uint8_t coverage,
+                                     BlendMode mode)
+{
+    // Отсечение один раз на серию: внутренний цикл без проверок
+    int along = (kind == SPAN_HORIZONTAL) ? x : y;
+    int across = (kind == SPAN_HORIZONTAL) ? y : x;
+    int limit = (kind == SPAN_HORIZONTAL) ? m_width : m_height;
+    int across_limit = (kind == SPAN_HORIZONTAL) ? m_height : m_width;
+    if (across < 0 || across >= across_limit) return;
+    int begin = std::max(along, 0);
+    int end = std::min(along + len, limit);
+    if (begin >= end) return;
+
+    simd::BlendSource src = simd::prepare_source(color, coverage, mode);
+    if (kind == SPAN_HORIZONTAL) {
+        simd::blend_row(&m_data[((size_t)y * m_width + begin) * 4], end - begin, src, mode);
+    } else {
+        uint8_t* p = &m_data[((size_t)begin * m_width + x) * 4];
+        for (int i = begin; i < end; ++i, p += stride()) simd::blend_one(p, src, mode);
+    }
+}
+
+void raster::Framebuffer::blend_coverage(int x, int y, Rgba8 color, uint8_t coverage)
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height || coverage == 0) return;
+    mix_pixel(&m_data[((size_t)y * m_width + x) * 4], LinearColor(color), coverage);
+}
+
+void raster::Framebuffer::blend_coverage_pair(SpanKind kind, int x, int y, Rgba8 color, uint8_t c0, uint8_t c1)
+{
+    int x2 = (kind == SPAN_HORIZONTAL) ? x + 1 : x;
+    int y2 = (kind == SPAN_HORIZONTAL) ? y : y + 1;
+    bool inside = x >= 0 && x2 < m_width && y >= 0 && y2 < m_height;
+    if (!inside) {
+        blend_coverage(x, y, color, c0);
+        blend_coverage(x2, y2, color, c1);
+        return;
+    }
+
+    LinearColor src(color);
+    uint8_t* p = &m_data[((size_t)y * m_width + x) * 4];
+    if (kind == SPAN_HORIZONTAL) {
+        // Оба пикселя подряд в памяти: одно чтение и одна запись 64 бит
+        uint8_t pair[8];
+        std::memcpy(pair, p, 8);
+        mix_pixel(pair, src, c0);
+        mix_pixel(pair + 4, src, c1);
+        std::memcpy(p, pair, 8);
+    } else {
+        mix_pixel(p, src, c0);
+        mix_pixel(p + stride(), src, c1);
+    }
+}
+
+raster::Rgba8 raster::rgba8(double r, double g, double b)
+{
+    return { (uint8_t)std::lround(std::clamp(r, 0.0, 1.0) * 255),
+             (uint8_t)std::lround(std::clamp(g, 0.0, 1.0) * 255),
+             (uint8_t)std::lround(std::clamp(b, 0.0, 1.0) * 255), 255 };
+}
+
+void raster::FramebufferSink::set_color(double r, double g, double b)
+{
+    m_color = rgba8(r, g, b);
+}
+
+void raster::FramebufferSink::pixel(int x, int y, uint8_t alpha)
+{
+    if (alpha != 255 && m_mode == BlendMode::SourceOver) m_fb.blend_coverage(x, y, m_color, alpha);
+    else m_fb.blend(x, y, m_color, alpha, m_mode);
+}
+
+void raster::FramebufferSink::span(SpanKind kind, int x, int y, int len)
+{
+    m_fb.blend_span(kind, x, y, len, m_color, 255, m_mode);
+}
+
+void raster::FramebufferSink::pixel_pair(SpanKind kind, int x, int y, uint8_t a0, uint8_t a1)
+{
+    if (m_mode == BlendMode::SourceOver) {
+        m_fb.blend_coverage_pair(kind, x, y, m_color, a0, a1);
+    } else {
+        m_fb.blend(x, y, m_color, a0, m_mode);
+        if (kind == SPAN_HORIZONTAL) m_fb.blend(x + 1, y, m_color, a1, m_mode);
+        else m_fb.blend(x, y + 1, m_color, a1, m_mode);
+    }
+}
+
+raster::TiledFramebuffer::TiledFramebuffer(int width, int height)
+{
+    resize(width, height);
+}
+
+void raster::TiledFramebuffer::resize(int width, int height)
+{
+    m_width = std::max(0, width);
+    m_height = std::max(0, height);
+    m_tiles_x = (m_width + TILE - 1) / TILE;
+    m_tiles_y = (m_height + TILE - 1) / TILE;
+    m_tiles.clear();
+    m_tiles.resize((size_t)m_tiles_x * m_tiles_y);
+    m_free.clear();
+    m_allocated = 0;
+    ++m_generation;
+}
+
+void raster::TiledFramebuffer::clear()
+{
+    if (m_allocated) {
+        for (std::unique_ptr<uint8_t[]>& t : m_tiles)
+            if (t) m_free.push_back(std::move(t));
+    }
+    m_allocated = 0;
+    ++m_generation;
+}
+
+uint8_t* raster::TiledFramebuffer::tile_for_write(int tx, int ty)
+{
+    std::unique_ptr<uint8_t[]>& t = m_tiles[(size_t)ty * m_tiles_x + tx];
+    if (!t) {
+        if (m_free.empty()) {
+            t.reset(new uint8_t[TILE * TILE * 4]);
+        } else {
+            t = std::move(m_free.back());
+            m_free.pop_back();
+        }
+        std::memset(t.get(), 255, TILE * TILE * 4);
+        ++m_allocated;
+    }
+    return t.get();
+}
+
+void raster::TiledFramebuffer::blend(int x, int y, Rgba8 color, uint8_t coverage, BlendMode mode)
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) return;
+    simd::blend_one(pixel_for_write(x, y), simd::prepare_source(color, coverage, mode), mode);
+}
+
+void raster::TiledFramebuffer::blend_span(SpanKind kind, int x, int y, int len, Rgba8 color, uint8_t coverage,
+                                          BlendMode mode)
+{
+    int along = (kind == SPAN_HORIZONTAL) ? x : y;
+    int across = (kind == SPAN_HORIZONTAL) ? y : x;
+    int limit = (kind == SPAN_HORIZONTAL) ? m_width : m_height;
+    int across_limit = (kind == SPAN_HORIZONTAL) ? m_height : m_width;
+    if (across < 0 || across >= across_limit) return;
+    int begin = std::max(along, 0);
+    int end = std::min(along + len, limit);
+    if (begin >= end) return;
+
+    // Куски серии внутри одной плитки: строка плитки непрерывна, столбец идет с шагом TILE * 4
+    simd::BlendSource src = simd::prepare_source(color, coverage, mode);
+    int t_across = across / TILE, in_across = across % TILE;
+    while (begin < end) {
+        int t_along = begin / TILE, in_along = begin % TILE;
+        int n = std::min(end - begin, TILE - in_along);
+        if (kind == SPAN_HORIZONTAL) {
+            uint8_t* p = tile_for_write(t_along, t_across) + (in_across * TILE + in_along) * 4;
+            simd::blend_row(p, n, src, mode);
+        } else {
+            uint8_t* p = tile_for_write(t_across, t_along) + (in_along * TILE + in_across) * 4;
+            for (int i = 0; i < n; ++i, p += tile_stride()) simd::blend_one(p, src, mode);
+        }
+        begin += n;
+    }
+}
+
+void raster::TiledFramebuffer::blend_coverage(int x, int y, Rgba8 color, uint8_t coverage)
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height || coverage == 0) return;
+    mix_pixel(pixel_for_write(x, y), LinearColor(color), coverage);
+}
+
+void raster::TiledFramebuffer::blend_coverage_pair(SpanKind kind, int x, int y, Rgba8 color, uint8_t c0, uint8_t c1)
+{
+    int x2 = (kind == SPAN_HORIZONTAL) ? x + 1 : x;
+    int y2 = (kind == SPAN_HORIZONTAL) ? y : y + 1;
+    bool inside = x >= 0 && x2 < m_width && y >= 0 && y2 < m_height;
+    if (!inside || x / TILE != x2 / TILE || y / TILE != y2 / TILE) {
+        blend_coverage(x, y, color, c0);
+        blend_coverage(x2, y2, color, c1);
+        return;
+    }
+
+    LinearColor src(color);
+    uint8_t* p = pixel_for_write(x, y);
+    mix_pixel(p, src, c0);
+    mix_pixel(p + ((kind == SPAN_HORIZONTAL) ? 4 : tile_stride()), src, c1);
+}
+
+void raster::TiledFramebufferSink::set_color(double r, double g, double b)
+{
+    m_color = rgba8(r, g, b);
+}
+
+void raster::TiledFramebufferSink::pixel(int x, int y, uint8_t alpha)
+{
+    if (alpha != 255 && m_mode == BlendMode::SourceOver) { m_fb.blend_coverage(x, y, m_color, alpha); return; }
+    if (x < 0 || x >= m_fb.width() || y < 0 || y >= m_fb.height()) return;
+
+    // Соседние точки линии почти всегда в той же плитке
+    const int T = TiledFramebuffer::TILE;
+    int tx = x / T, ty = y / T;
+    if (tx != m_tile_x || ty != m_tile_y || m_generation != m_fb.generation() || !m_tile) {
+        m_tile = m_fb.tile_for_write(tx, ty);
+        m_tile_x = tx;
+        m_tile_y = ty;
+        m_generation = m_fb.generation();
+    }
+    simd::blend_one(m_tile + ((y - ty * T) * T + (x - tx * T)) * 4, simd::prepare_source(m_color, alpha, m_mode), m_mode);
+}
+
+void raster::TiledFramebufferSink::span(SpanKind kind, int x, int y, int len)
+{
+    m_fb.blend_span(kind, x, y, len, m_color, 255, m_mode);
+}
+
+void raster::TiledFramebufferSink::pixel_pair(SpanKind kind, int x, int y, uint8_t a0, uint8_t a1)
+{
+    if (m_mode == BlendMode::SourceOver) {
+        m_fb.blend_coverage_pair(kind, x, y, m_color, a0, a1);
+    } else {
+        pixel(x, y, a0);
+        if (kind == SPAN_HORIZONTAL) pixel(x + 1, y, a1);
+        else pixel(x, y + 1, a1);
+    }
+}
@@ -0,0 +1,285 @@
+#include "rastergen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    using raster::ClipRect;
+    using raster::PixelSink;
+    using raster::PrimitiveGenerator;
+
+    /**
+     * @brief Отрезок полосами по основной оси: шаг k лежит в start + s * k, порция -
+     * clip, суженный по основной оси до шагов [k, k + CHUNK). Шаги вне clip по основной
+     * оси пропускаются сразу.
+     */
+    class LineGenerator : public PrimitiveGenerator
+    {
+    public:
+        LineGenerator(raster::LineClippedFn draw, int x1, int y1, int x2, int y2, const ClipRect& clip)
+            : m_draw(draw), m_x1(x1), m_y1(y1), m_x2(x2), m_y2(y2), m_clip(clip)
+        {
+            m_x_major = std::abs((int64_t)x2 - x1) >= std::abs((int64_t)y2 - y1);
+            m_start = m_x_major ? x1 : y1;
+            int end = m_x_major ? x2 : y2;
+            m_step = (end >= m_start) ? 1 : -1;
+            int64_t n = std::abs((int64_t)end - m_start);
+            int lo = m_x_major ? clip.x0 : clip.y0, hi = m_x_major ? clip.x1 : clip.y1;
+            m_k = std::max<int64_t>(0, (m_step > 0) ? (int64_t)lo - m_start : (int64_t)m_start - hi);
+            m_k_last = std::min<int64_t>(n, (m_step > 0) ? (int64_t)hi - m_start : (int64_t)m_start - lo);
+
+            // Рамка отрезка мимо clip по второй оси - рисовать нечего
+            int m_lo = m_x_major ? std::min(y1, y2) : std::min(x1, x2);
+            int m_hi = m_x_major ? std::max(y1, y2) : std::max(x1, x2);
+            if (clip.empty() || m_hi < (m_x_major ? clip.y0 : clip.x0) || m_lo > (m_x_major ? clip.y1 : clip.x1))
+                m_k = m_k_last + 1;
+        }
+
+        bool next(PixelSink& sink) override
+        {
+            if (m_k > m_k_last) return false;
+            int64_t k1 = std::min<int64_t>(m_k + CHUNK - 1, m_k_last);
+            int64_t a = m_start + m_step * m_k, b = m_start + m_step * k1;
+            ClipRect c = m_clip;
+            int& lo = m_x_major ? c.x0 : c.y0;
+            int& hi = m_x_major ? c.x1 : c.y1;
+            lo = (int)std::min(a, b);
+            hi = (int)std::max(a, b);
+            m_draw(sink, m_x1, m_y1, m_x2, m_y2, c);
+            m_k = k1 + 1;
+            return true;
+        }
+
+    private:
+        raster::LineClippedFn m_draw;
+        int m_x1, m_y1, m_x2, m_y2;
+        ClipRect m_clip;
+        bool m_x_major;
+        int m_start, m_step;
+        int64_t m_k, m_k_last;
+    };
+
+    /**
+     * @brief Окружность: порция - x октантов в [x, x + CHUNK). Видимые x восьми октантов
+     * считаются в конструкторе и сливаются в отрезки; x между ними пропускаются сразу,
+     * поэтому число порций зависит от видимой части, а не от радиуса.
+     */
+    class CircleGenerator : public PrimitiveGenerator
+    {
+    public:
+        CircleGenerator(int cx, int cy, int radius, const ClipRect& clip)
+            : m_cx(cx), m_cy(cy), m_radius(radius), m_clip(clip)
+        {
+            int64_t lo[8], hi[8];
+            raster::bresenham_circle_visible_x(cx, cy, radius, clip, lo, hi);
+            std::pair<int64_t, int64_t> ranges[8];
+            int n = 0;
+            for (int o = 0; o < 8; ++o)
+                if (lo[o] <= hi[o]) ranges[n++] = {lo[o], hi[o]};
+            std::sort(ranges, ranges + n);
+            for (int i = 0; i < n; ++i) {
+                if (m_count && ranges[i].first <= m_hi[m_count - 1] + 1) {
+                    m_hi[m_count - 1] = std::max(m_hi[m_count - 1], ranges[i].second);
+                } else {
+                    m_lo[m_count] = ranges[i].first;
+                    m_hi[m_count] = ranges[i].second;
+                    ++m_count;
+                }
+            }
+            if (m_count) m_x = m_lo[0];
+        }
+
+        bool next(PixelSink& sink) override
+        {
+            while (m_range < m_count && m_x > m_hi[m_range]) ++m_range;
+            if (m_range >= m_count) return false;
+            m_x = std::max(m_x, m_lo[m_range]);
+            int64_t x1 = std::min<int64_t>(m_x + CHUNK - 1, m_hi[m_range]);
+            raster::bresenham_circle_clipped(sink, m_cx, m_cy, m_radius, m_clip, (int)m_x, (int)x1);
+            m_x = x1 + 1;
+            return true;
+        }
+
+    private:
+        int m_cx, m_cy, m_radius;
+        ClipRect m_clip;
+        int64_t m_lo[8], m_hi[8];  ///< Непересекающиеся отрезки видимых x по возрастанию.
+        int m_count = 0, m_range = 0;
+        int64_t m_x = 0;
+    };
+
+    /**
+     * @brief Круг: строки cy + k и cy - k для k от ближайшей к центру видимой строки,
+     * каждая строка - fill_circle с clip в одну строку.
+     */
+    class FillCircleGenerator : public PrimitiveGenerator
+    {
+    public:
+        FillCircleGenerator(int cx, int cy, int radius, const ClipRect& clip)
+            : m_cx(cx), m_cy(cy), m_radius(radius), m_clip(clip)
+        {
+            m_k = std::max<int64_t>({0, (int64_t)clip.y0 - cy, (int64_t)cy - clip.y1});
+            if (cy >= clip.y0 && cy <= clip.y1) m_k = 0;
+            m_k_last = std::min<int64_t>(radius, std::max((int64_t)clip.y1 - cy, (int64_t)cy - clip.y0));
+            if (radius < 0 || clip.empty()) m_k = m_k_last + 1;
+        }
+
+        bool next(PixelSink& sink) override
+        {
+            if (m_k > m_k_last) return false;
+            int64_t k1 = std::min<int64_t>(m_k + CHUNK - 1, m_k_last);
+            for (int64_t k = m_k; k <= k1; ++k) {
+                row(sink, (int64_t)m_cy + k);
+                if (k) row(sink, (int64_t)m_cy - k);
+            }
+            m_k = k1 + 1;
+            return true;
+        }
+
+    private:
+        void row(PixelSink& sink, int64_t y)
+        {
+            if (y < m_clip.y0 || y > m_clip.y1) return;
+            raster::fill_circle(sink, m_cx, m_cy, m_radius, {m_clip.x0, (int)y, m_clip.x1, (int)y});
+        }
+
+        int m_cx, m_cy, m_radius;
+        ClipRect m_clip;
+        int64_t m_k, m_k_last;
+    };
+
+    /**
+     * @brief Заливка ломаных: полосы по CHUNK строк между верхней и нижней вершиной.
+     */
+    class FillPolylineGenerator : public PrimitiveGenerator
+    {
+    public:
+        FillPolylineGenerator(raster::Polyline lines, raster::FillRule rule, const ClipRect& clip)
+            : m_lines(std::move(lines)), m_rule(rule), m_clip(clip)
+        {
+            m_y = 0;
+            m_y_last = -1;
+            if (m_lines.points.empty() || clip.empty()) return;
+            double y0 = m_lines.points[0].y, y1 = y0;
+            for (const raster::PointD& p : m_lines.points) {
+                y0 = std::min(y0, p.y);
+                y1 = std::max(y1, p.y);
+            }
+            // Строки, центры которых между верхней и нижней вершиной
+            m_y = std::max<int64_t>(clip.y0, (int64_t)std::floor(std::max(y0, -2e9)));
+            m_y_last = std::min<int64_t>(clip.y1, (int64_t)std::ceil(std::min(y1, 2e9)));
+        }
+
+        bool next(PixelSink& sink) override
+        {
+            if (m_y > m_y_last) return false;
+            int64_t y1 = std::min<int64_t>(m_y + CHUNK - 1, m_y_last);
+            raster::fill_polyline(sink, m_lines, m_rule, {m_clip.x0, (int)m_y, m_clip.x1, (int)y1});
+            m_y = y1 + 1;
+            return true;
+        }
+
+    private:
+        raster::Polyline m_lines;
+        raster::FillRule m_rule;
+        ClipRect m_clip;
+        int64_t m_y, m_y_last;
+    };
+} // namespace
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_line_generator(LineClippedFn draw, int x1, int y1, int x2,
+                                                                        int y2, const ClipRect& clip)
+{
+    return std::make_unique<LineGenerator>(draw, x1, y1, x2, y2, clip);
+}
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_circle_generator(int cx, int cy, int radius,
+                                                                          const ClipRect& clip)
+{
+    return std::make_unique<CircleGenerator>(cx, cy, radius, clip);
+}
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_bezier_quadratic_generator(int x1, int y1, int cx, int cy,
+                                                                                    int x2, int y2,
+                                                                                    const ClipRect& clip)
+{
+    Path path;
+    path.move_to(x1, y1);
+    path.quad_to(cx, cy, x2, y2);
+    Polyline lines;
+    flatten_path(path, 0.25, lines);
+    return make_polyline_generator(std::move(lines), clip);
+}
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_bezier_cubic_generator(int x1, int y1, int c1x, int c1y,
+                                                                                int c2x, int c2y, int x2, int y2,
+                                                                                const ClipRect& clip)
+{
+    Path path;
+    path.move_to(x1, y1);
+    path.cubic_to(c1x, c1y, c2x, c2y, x2, y2);
+    Polyline lines;
+    flatten_path(path, 0.25, lines);
+    return make_polyline_generator(std::move(lines), clip);
+}
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_fill_circle_generator(int cx, int cy, int radius,
+                                                                               const ClipRect& clip)
+{
+    return std::make_unique<FillCircleGenerator>(cx, cy, radius, clip);
+}
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_fill_polygon_generator(std::vector<PointD> points,
+                                                                                FillRule rule, const ClipRect& clip)
+{
+    Polyline lines;
+    lines.points = std::move(points);
+    lines.starts.push_back(0);
+    lines.closed.push_back(1);
+    return make_fill_polyline_generator(std::move(lines), rule, clip);
+}
+
+std::unique_ptr<raster::PrimitiveGenerator> raster::make_fill_polyline_generator(Polyline lines, FillRule rule,
+                                                                                 const ClipRect& clip)
+{
+    return std::make_unique<FillPolylineGenerator>(std::move(lines), rule, clip);
+}
+
+void raster::GeneratorQueue::add(std::unique_ptr<PrimitiveGenerator> generator, double r, double g, double b)
+{
+    m_active.push_back({std::move(generator), r, g, b});
+}
+
+bool raster::GeneratorQueue::pull(CommandBuffer& commands)
+{
+    for (int empty = 0; !m_active.empty(); ++empty) {
+        // Порции без пикселей не должны держать кадр: вернуться к планировщику, продолжить в следующем
+        if (empty == MAX_EMPTY_STEPS) return false;
+        if (m_next >= m_active.size()) m_next = 0;
+        Entry& e = m_active[m_next];
+        // Палитра занята неотыгранными командами: сначала их нужно проиграть
+        if (!commands.set_color(e.r, e.g, e.b)) return false;
+        size_t before = commands.size();
+        if (!e.generator->next(commands)) {
+            // Порядок оставшихся сохраняется: очередь по кругу не перескакивает примитивы
+            m_active.erase(m_active.begin() + m_next);
+            continue;
+        }
+        ++m_next;
+        if (commands.size() > before) return true;
+    }
+    return false;
+}
+
+void raster::GeneratorQueue::clear()
+{
+    m_active.clear();
+    m_next = 0;
+}
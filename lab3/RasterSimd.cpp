@@ -0,0 +1,255 @@
+#include "rastersimd.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RASTER_X86 1
+#endif
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    using RoundAffineFn = void (*)(double, double, int64_t, int, int*);
+
+    void round_affine_scalar(double base, double inc, int64_t first, int count, int* out)
+    {
+        for (int j = 0; j < count; ++j) out[j] = (int)std::round(base + (double)(first + j) * inc);
+    }
+
+#ifdef RASTER_X86
+    // round(v) = trunc(v + copysign(0.49999999999999994, v)): наибольшее double меньше 0.5
+    // не дает ошибки на v = 0.49999999999999994 и совпадает с std::round на всех |v| < 2^52.
+    // Усечение делает само преобразование cvttpd.
+    const double HALF_BELOW = 0.49999999999999994;
+
+    __attribute__((target("sse2")))
+    inline __m128i lane_sse2(__m128d idx, __m128d base, __m128d inc, __m128d sign, __m128d half)
+    {
+        __m128d v = _mm_add_pd(base, _mm_mul_pd(idx, inc));
+        v = _mm_add_pd(v, _mm_or_pd(half, _mm_and_pd(v, sign)));
+        return _mm_cvttpd_epi32(v); // 2 int32 в младшей половине
+    }
+
+    __attribute__((target("sse2")))
+    void round_affine_sse2(double base, double inc, int64_t first, int count, int* out)
+    {
+        const __m128d vbase = _mm_set1_pd(base);
+        const __m128d vinc = _mm_set1_pd(inc);
+        const __m128d sign = _mm_set1_pd(-0.0);
+        const __m128d half = _mm_set1_pd(HALF_BELOW);
+        const __m128d step = _mm_set1_pd(2.0);
+
+        int j = 0;
+        __m128d idx = _mm_set_pd(first + 1.0, (double)first);
+        for (; j + 8 <= count; j += 8) {
+            __m128i a = lane_sse2(idx, vbase, vinc, sign, half); idx = _mm_add_pd(idx, step);
+            __m128i b = lane_sse2(idx, vbase, vinc, sign, half); idx = _mm_add_pd(idx, step);
+            __m128i c = lane_sse2(idx, vbase, vinc, sign, half); idx = _mm_add_pd(idx, step);
+            __m128i d = lane_sse2(idx, vbase, vinc, sign, half); idx = _mm_add_pd(idx, step);
+            _mm_storeu_si128((__m128i*)(out + j), _mm_unpacklo_epi64(a, b));
+            _mm_storeu_si128((__m128i*)(out + j + 4), _mm_unpacklo_epi64(c, d));
+        }
+        round_affine_scalar(base, inc, first + j, count - j, out + j);
+    }
+
+    __attribute__((target("avx")))
+    inline __m128i lane_avx(__m256d idx, __m256d base, __m256d inc, __m256d sign, __m256d half)
+    {
+        __m256d v = _mm256_add_pd(base, _mm256_mul_pd(idx, inc));
+        v = _mm256_add_pd(v, _mm256_or_pd(half, _mm256_and_pd(v, sign)));
+        return _mm256_cvttpd_epi32(v); // 4 int32
+    }
+
+    __attribute__((target("avx")))
+    void round_affine_avx(double base, double inc, int64_t first, int count, int* out)
+    {
+        const __m256d vbase = _mm256_set1_pd(base);
+        const __m256d vinc = _mm256_set1_pd(inc);
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        const __m256d half = _mm256_set1_pd(HALF_BELOW);
+        const __m256d step = _mm256_set1_pd(4.0);
+
+        int j = 0;
+        __m256d idx = _mm256_set_pd(first + 3.0, first + 2.0, first + 1.0, (double)first);
+        for (; j + 16 <= count; j += 16) {
+            __m128i a = lane_avx(idx, vbase, vinc, sign, half); idx = _mm256_add_pd(idx, step);
+            __m128i b = lane_avx(idx, vbase, vinc, sign, half); idx = _mm256_add_pd(idx, step);
+            __m128i c = lane_avx(idx, vbase, vinc, sign, half); idx = _mm256_add_pd(idx, step);
+            __m128i d = lane_avx(idx, vbase, vinc, sign, half); idx = _mm256_add_pd(idx, step);
+            _mm_storeu_si128((__m128i*)(out + j), a);
+            _mm_storeu_si128((__m128i*)(out + j + 4), b);
+            _mm_storeu_si128((__m128i*)(out + j + 8), c);
+            _mm_storeu_si128((__m128i*)(out + j + 12), d);
+        }
+        // Хвост считает SSE-код без VEX: без vzeroupper переход стоит сотни тактов
+        _mm256_zeroupper();
+        round_affine_sse2(base, inc, first + j, count - j, out + j);
+    }
+#endif
+
+    using raster::BlendMode;
+    using raster::simd::BlendSource;
+    using BlendRowFn = void (*)(uint8_t*, int, const BlendSource&, BlendMode);
+
+    void blend_row_scalar(uint8_t* dst, int len, const BlendSource& src, BlendMode mode)
+    {
+        for (int i = 0; i < len; ++i) raster::simd::blend_one(dst + i * 4, src, mode);
+    }
+
+#ifdef RASTER_X86
+    // Ядра смешивания: 8-битные каналы расширяются до 16 бит, x / 255 считается как
+    // mulhi(x + 128, 257) - то же, что div255 в скалярной версии.
+
+    __attribute__((target("sse2")))
+    inline __m128i div255_sse2(__m128i x)
+    {
+        return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+    }
+
+    /**
+     * @brief Два пикселя в 16-битных каналах (8 слов).
+     */
+    __attribute__((target("sse2")))
+    inline __m128i blend_half_sse2(__m128i d, __m128i s, __m128i keep, __m128i s_inv_alpha, BlendMode mode)
+    {
+        if (mode == BlendMode::Multiply) {
+            const __m128i full = _mm_set1_epi16(255);
+            __m128i da = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xFF), 0xFF); // альфа пикселя во все каналы
+            __m128i t1 = div255_sse2(_mm_mullo_epi16(s, d));
+            __m128i t2 = div255_sse2(_mm_mullo_epi16(s, _mm_sub_epi16(full, da)));
+            __m128i t3 = div255_sse2(_mm_mullo_epi16(d, s_inv_alpha));
+            return _mm_add_epi16(_mm_add_epi16(t1, t2), t3);
+        }
+        return _mm_add_epi16(s, div255_sse2(_mm_mullo_epi16(d, keep)));
+    }
+
+    __attribute__((target("sse2")))
+    void blend_row_sse2(uint8_t* dst, int len, const BlendSource& src, BlendMode mode)
+    {
+        uint32_t packed;
+        std::memcpy(&packed, src.bgra, 4);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i s8 = _mm_set1_epi32((int)packed);
+        const __m128i s16 = _mm_unpacklo_epi8(s8, zero);
+        const __m128i keep = _mm_set1_epi16(src.keep);
+        const __m128i s_inv_alpha = _mm_set1_epi16((short)(255 - src.bgra[3]));
+
+        int i = 0;
+        for (; i + 4 <= len; i += 4) {
+            __m128i* p = (__m128i*)(dst + i * 4);
+            __m128i d = _mm_loadu_si128(p);
+            __m128i r;
+            if (mode == BlendMode::Additive) {
+                r = _mm_adds_epu8(d, s8);
+            } else {
+                __m128i lo = blend_half_sse2(_mm_unpacklo_epi8(d, zero), s16, keep, s_inv_alpha, mode);
+                __m128i hi = blend_half_sse2(_mm_unpackhi_epi8(d, zero), s16, keep, s_inv_alpha, mode);
+                r = _mm_packus_epi16(lo, hi);
+            }
+            _mm_storeu_si128(p, r);
+        }
+        blend_row_scalar(dst + i * 4, len - i, src, mode);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i div255_avx2(__m256i x)
+    {
+        return _mm256_mulhi_epu16(_mm256_add_epi16(x, _mm256_set1_epi16(128)), _mm256_set1_epi16(257));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i blend_half_avx2(__m256i d, __m256i s, __m256i keep, __m256i s_inv_alpha, BlendMode mode)
+    {
+        if (mode == BlendMode::Multiply) {
+            const __m256i full = _mm256_set1_epi16(255);
+            __m256i da = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(d, 0xFF), 0xFF);
+            __m256i t1 = div255_avx2(_mm256_mullo_epi16(s, d));
+            __m256i t2 = div255_avx2(_mm256_mullo_epi16(s, _mm256_sub_epi16(full, da)));
+            __m256i t3 = div255_avx2(_mm256_mullo_epi16(d, s_inv_alpha));
+            return _mm256_add_epi16(_mm256_add_epi16(t1, t2), t3);
+        }
+        return _mm256_add_epi16(s, div255_avx2(_mm256_mullo_epi16(d, keep)));
+    }
+
+    __attribute__((target("avx2")))
+    void blend_row_avx2(uint8_t* dst, int len, const BlendSource& src, BlendMode mode)
+    {
+        uint32_t packed;
+        std::memcpy(&packed, src.bgra, 4);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i s8 = _mm256_set1_epi32((int)packed);
+        const __m256i s16 = _mm256_unpacklo_epi8(s8, zero);
+        const __m256i keep = _mm256_set1_epi16(src.keep);
+        const __m256i s_inv_alpha = _mm256_set1_epi16((short)(255 - src.bgra[3]));
+
+        int i = 0;
+        for (; i + 8 <= len; i += 8) {
+            __m256i* p = (__m256i*)(dst + i * 4);
+            __m256i d = _mm256_loadu_si256(p);
+            __m256i r;
+            if (mode == BlendMode::Additive) {
+                r = _mm256_adds_epu8(d, s8);
+            } else {
+                // unpack/pack работают внутри 128-битных половин, порядок пикселей сохраняется
+                __m256i lo = blend_half_avx2(_mm256_unpacklo_epi8(d, zero), s16, keep, s_inv_alpha, mode);
+                __m256i hi = blend_half_avx2(_mm256_unpackhi_epi8(d, zero), s16, keep, s_inv_alpha, mode);
+                r = _mm256_packus_epi16(lo, hi);
+            }
+            _mm256_storeu_si256(p, r);
+        }
+        _mm256_zeroupper();
+        blend_row_sse2(dst + i * 4, len - i, src, mode);
+    }
+#endif
+
+    struct Dispatch
+    {
+        RoundAffineFn round_affine;
+        const char* name;
+        BlendRowFn blend_row;
+        const char* blend_name;
+    };
+
+    const Dispatch& dispatch()
+    {
+        static const Dispatch d = [] {
+            Dispatch r = {round_affine_scalar, "scalar", blend_row_scalar, "scalar"};
+#ifdef RASTER_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse2")) {
+                r.round_affine = round_affine_sse2; r.name = "sse2";
+                r.blend_row = blend_row_sse2; r.blend_name = "sse2";
+            }
+            if (__builtin_cpu_supports("avx")) { r.round_affine = round_affine_avx; r.name = "avx"; }
+            if (__builtin_cpu_supports("avx2")) { r.blend_row = blend_row_avx2; r.blend_name = "avx2"; }
+#endif
+            return r;
+        }();
+        return d;
+    }
+} // namespace
+
+
+void raster::simd::round_affine(double base, double inc, int64_t first, int count, int* out)
+{
+    dispatch().round_affine(base, inc, first, count, out);
+}
+
+const char* raster::simd::isa_name()
+{
+    return dispatch().name;
+}
+
+void raster::simd::blend_row(uint8_t* dst, int len, const BlendSource& src, BlendMode mode)
+{
+    dispatch().blend_row(dst, len, src, mode);
+}
+
+const char* raster::simd::blend_isa_name()
+{
+    return dispatch().blend_name;
+}
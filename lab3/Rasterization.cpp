@@ -0,0 +1,811 @@
+#include "rasterlib.hpp"
+#include "rastersimd.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    /**
+     * @brief Серия октанта x0..x1 при постоянном y: горизонтальные серии в четырех
+     * октантах и вертикальные - в четырех симметричных.
+     */
+    void push_circle_runs(raster::PixelSink& sink, int cx, int cy, int x0, int x1, int y)
+    {
+        int len = x1 - x0 + 1;
+        sink.span(raster::SPAN_HORIZONTAL, cx + x0, cy + y, len);
+        sink.span(raster::SPAN_HORIZONTAL, cx - x1, cy + y, len);
+        sink.span(raster::SPAN_HORIZONTAL, cx + x0, cy - y, len);
+        sink.span(raster::SPAN_HORIZONTAL, cx - x1, cy - y, len);
+        sink.span(raster::SPAN_VERTICAL, cx + y, cy + x0, len);
+        sink.span(raster::SPAN_VERTICAL, cx - y, cy + x0, len);
+        sink.span(raster::SPAN_VERTICAL, cx + y, cy - x1, len);
+        sink.span(raster::SPAN_VERTICAL, cx - y, cy - x1, len);
+    }
+
+    /**
+     * @brief Серия из len пикселей от (x, y). При отсечении по всему диапазону int
+     * длина может не поместиться в int - тогда серия выдается частями.
+     */
+    void long_span(raster::PixelSink& sink, raster::SpanKind kind, int64_t x, int64_t y, int64_t len)
+    {
+        while (len > 0) {
+            int part = (int)std::min<int64_t>(len, INT_MAX);
+            sink.span(kind, (int)x, (int)y, part);
+            if (kind == raster::SPAN_HORIZONTAL) x += part; else y += part;
+            len -= part;
+        }
+    }
+
+    /**
+     * @brief Первое i в [lo, hi), для которого pred истинно (hi, если нет); pred монотонен.
+     */
+    template <class Pred>
+    int64_t first_true(int64_t lo, int64_t hi, Pred pred)
+    {
+        while (lo < hi) {
+            int64_t mid = lo + (hi - lo) / 2;
+            if (pred(mid)) hi = mid; else lo = mid + 1;
+        }
+        return lo;
+    }
+
+    /**
+     * @brief Диапазон шагов [k_lo, k_hi] внутри [0, n], на которых координата
+     * start + step * k попадает в [lo, hi]. Пусто, если k_lo > k_hi.
+     */
+    void axis_range(int start, int step, int64_t n, int lo, int hi, int64_t& k_lo, int64_t& k_hi)
+    {
+        k_lo = std::max<int64_t>(0, (step > 0) ? (int64_t)lo - start : (int64_t)start - hi);
+        k_hi = std::min<int64_t>(n, (step > 0) ? (int64_t)hi - start : (int64_t)start - lo);
+    }
+
+    /**
+     * @brief Параметры октанта окружности: точка (x, y) октанта выходит в пиксель
+     * (cx + sa * x, cy + sb * y), а при swap - в (cx + sb * y, cy + sa * x).
+     */
+    struct CircleOctant
+    {
+        int sa, sb;
+        bool swap;
+    };
+
+    // В порядке push_circle_runs
+    const CircleOctant CIRCLE_OCTANTS[8] = {
+        {1, 1, false}, {-1, 1, false}, {1, -1, false}, {-1, -1, false},
+        {1, 1, true}, {1, -1, true}, {-1, 1, true}, {-1, -1, true},
+    };
+
+    /**
+     * @brief Наибольшее y с 2x^2 + 2y^2 - 2y + 1 < 2r^2 (средняя точка (x, y - 1/2) внутри
+     * окружности): столбец x первого октанта окружности Брезенхема до последнего шага.
+     * Неравенство переписано через (r - y)(r + y), чтобы при радиусе до INT_MAX
+     * и x в пределах октанта не было переполнения int64.
+     */
+    int64_t circle_midpoint_y(int64_t r, int64_t x)
+    {
+        auto inside = [&](int64_t y) { return 2 * x * x + 1 - 2 * y < 2 * (r - y) * (r + y); };
+        int64_t y = (int64_t)std::floor(0.5 + std::sqrt(std::max(0.0, (double)r * r - (double)x * x - 0.25)));
+        while (inside(y + 1)) ++y;
+        while (y > 0 && !inside(y)) --y;
+        return y;
+    }
+
+    /**
+     * @brief Отрезок [lo, hi] значений x, при которых точка октанта o попадает в clip.
+     */
+    void circle_octant_range(const CircleOctant& o, int cx, int cy, int radius, int x_end, const raster::ClipRect& clip,
+                             int64_t& lo, int64_t& hi)
+    {
+        int ca = o.swap ? cy : cx, cb = o.swap ? cx : cy;
+        int a_lo = o.swap ? clip.y0 : clip.x0, a_hi = o.swap ? clip.y1 : clip.x1;
+        int b_lo = o.swap ? clip.x0 : clip.y0, b_hi = o.swap ? clip.x1 : clip.y1;
+        axis_range(ca, o.sa, x_end, a_lo, a_hi, lo, hi);
+        if (lo > hi) return;
+
+        // y по x не возрастает: границы по второй оси - двоичным поиском
+        int64_t y_lo = (o.sb > 0) ? (int64_t)b_lo - cb : (int64_t)cb - b_hi;
+        int64_t y_hi = (o.sb > 0) ? (int64_t)b_hi - cb : (int64_t)cb - b_lo;
+        auto y_at = [&](int64_t x) { return raster::bresenham_circle_y(radius, (int)x); };
+        lo = first_true(lo, hi + 1, [&](int64_t x) { return y_at(x) <= y_hi; });
+        hi = first_true(lo, hi + 1, [&](int64_t x) { return y_at(x) < y_lo; }) - 1;
+    }
+
+    /**
+     * @brief Точки прямой с точной основной координатой maj0 + s_maj * i и второй
+     * round(min0 + i * inc), i = i0..i1. Вторые координаты считаются векторно
+     * блоками, точки выдаются сериями с постоянной второй координатой.
+     */
+    void affine_runs(raster::PixelSink& sink, bool x_major, int maj0, int s_maj, double min0, double inc, int64_t i0,
+                     int64_t i1)
+    {
+        const int BLOCK = 256;
+        int buf[BLOCK];
+        int64_t run_start = i0;
+        int run_value = 0;
+        auto flush = [&](int64_t end) { // серия [run_start, end)
+            int64_t a = (s_maj > 0) ? maj0 + run_start : maj0 - (end - 1);
+            if (x_major) long_span(sink, raster::SPAN_HORIZONTAL, a, run_value, end - run_start);
+            else long_span(sink, raster::SPAN_VERTICAL, run_value, a, end - run_start);
+        };
+
+        for (int64_t first = i0; first <= i1; first += BLOCK) {
+            int count = (int)std::min<int64_t>(BLOCK, i1 - first + 1);
+            raster::simd::round_affine(min0, inc, first, count, buf);
+            if (first == i0) run_value = buf[0];
+            for (int j = 0; j < count; ++j) {
+                if (buf[j] != run_value) {
+                    flush(first + j);
+                    run_start = first + j;
+                    run_value = buf[j];
+                }
+            }
+        }
+        flush(i1 + 1);
+    }
+
+    /**
+     * @brief Отсечение affine_runs: шаги i, у которых обе координаты внутри clip.
+     * round(min0 + i * inc) монотонна по i, поэтому границы по второй оси ищутся
+     * двоичным поиском по той же формуле, что и в round_affine: точки не сдвигаются.
+     */
+    void affine_runs_clipped(raster::PixelSink& sink, bool x_major, int maj0, int s_maj, double min0, double inc,
+                             int64_t n, const raster::ClipRect& clip)
+    {
+        int64_t lo, hi;
+        axis_range(maj0, s_maj, n, x_major ? clip.x0 : clip.y0, x_major ? clip.x1 : clip.y1, lo, hi);
+        if (lo > hi) return;
+
+        double min_lo = x_major ? clip.y0 : clip.x0, min_hi = x_major ? clip.y1 : clip.x1;
+        auto minor = [&](int64_t i) { return std::round(min0 + (double)i * inc); };
+        if (inc >= 0) {
+            lo = first_true(lo, hi + 1, [&](int64_t i) { return minor(i) >= min_lo; });
+            hi = first_true(lo, hi + 1, [&](int64_t i) { return minor(i) > min_hi; }) - 1;
+        } else {
+            lo = first_true(lo, hi + 1, [&](int64_t i) { return minor(i) <= min_hi; });
+            hi = first_true(lo, hi + 1, [&](int64_t i) { return minor(i) < min_lo; }) - 1;
+        }
+        if (lo <= hi) affine_runs(sink, x_major, maj0, s_maj, min0, inc, lo, hi);
+    }
+
+    /**
+     * @brief Деление с округлением вниз/вверх для любых знаков (b > 0).
+     */
+    inline int64_t floor_div(int64_t a, int64_t b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+    inline int64_t ceil_div(int64_t a, int64_t b) { return -floor_div(-a, b); }
+
+    /**
+     * @brief То же для произведений разностей координат: при разностях до 2^32
+     * они выходят за int64 (GCC/Clang, как и target-атрибуты в RasterSimd.cpp).
+     */
+    using wide_t = __int128;
+    inline wide_t floor_div(wide_t a, wide_t b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+    inline wide_t ceil_div(wide_t a, wide_t b) { return -floor_div(-a, b); }
+    /**
+     * @brief Цепочка шагов Кастла-Питвея: узел - "child повторить rep раз, затем tail"
+     * (tail < 0 - нет), узлы S и D - одиночные шаги. Дети всегда раньше родителя.
+     */
+    struct CastleChain
+    {
+        struct Node { int child; int64_t rep; int tail; };
+        // Шагов деления у алгоритма Евклида для разностей до 2^32 не больше ~47, узлов - на 4 больше
+        static const int S = 0, D = 1, MAX_NODES = 128;
+        Node nodes[MAX_NODES];
+        int count;
+        int root;
+    };
+
+    /**
+     * @brief Строит цепочку для отрезка с a шагами по основной оси и b по второй (a >= b):
+     * серия одинаковых вычитаний алгоритма Евклида сворачивается в одно деление.
+     */
+    void build_castle_chain(int64_t a, int64_t b, CastleChain& c)
+    {
+        const int S = CastleChain::S, D = CastleChain::D;
+        c.nodes[S] = {-1, 0, -1};
+        c.nodes[D] = {-1, 0, -1};
+        c.count = 2;
+        auto add = [&c](int child, int64_t rep, int tail) {
+            c.nodes[c.count] = {child, rep, tail};
+            return c.count++;
+        };
+
+        if (b == 0) {
+            c.root = add(S, a, -1);
+        } else if (a == b) {
+            c.root = add(D, a, -1);
+        } else {
+            int64_t x_alg = a - b;
+            int64_t y_alg = b;
+            int m1 = S, m2 = D;
+            while (x_alg != y_alg) {
+                if (x_alg > y_alg) {
+                    int64_t q = (x_alg - 1) / y_alg;   // m2 = m1 + m2, q раз подряд
+                    x_alg -= q * y_alg;
+                    m2 = add(m1, q, m2);
+                } else {
+                    int64_t q = (y_alg - 1) / x_alg;   // m1 = m2 + m1, q раз подряд
+                    y_alg -= q * x_alg;
+                    m1 = add(m2, q, m1);
+                }
+            }
+            int pattern = add(m2, 1, m1);          // pattern = m2 + m1
+            c.root = add(pattern, x_alg, -1);      // pattern повторяется НОД раз
+        }
+    }
+} // namespace
+
+
+void raster::PixelSink::span(SpanKind kind, int x, int y, int len)
+{
+    if (kind == SPAN_HORIZONTAL) {
+        for (int i = 0; i < len; ++i) pixel(x + i, y, 255);
+    } else {
+        for (int i = 0; i < len; ++i) pixel(x, y + i, 255);
+    }
+}
+
+void raster::PixelSink::pixel_pair(SpanKind kind, int x, int y, uint8_t a0, uint8_t a1)
+{
+    pixel(x, y, a0);
+    if (kind == SPAN_HORIZONTAL) pixel(x + 1, y, a1); else pixel(x, y + 1, a1);
+}
+
+// Точка с номером i считается как x1 + i * inc (а не накоплением inc), поэтому
+// каждую точку можно посчитать независимо, в том числе векторно.
+void raster::step_line_reference(PixelSink& sink, int x1, int y1, int x2, int y2)
+{
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    if (dx == 0 && dy == 0) { sink.pixel(x1, y1, 255); return; }
+
+    if (std::abs(dx) >= std::abs(dy)) {
+        if (x1 > x2) { std::swap(x1, x2); std::swap(y1, y2); }
+        double k = (double)(y2 - y1) / (x2 - x1);
+        for (int x = x1; x <= x2; x++) {
+            sink.pixel(x, (int)std::round(y1 + (double)(x - x1) * k), 255);
+        }
+    } else {
+        if (y1 > y2) { std::swap(x1, x2); std::swap(y1, y2); }
+        double k = (double)(x2 - x1) / (y2 - y1);
+        for (int y = y1; y <= y2; y++) {
+            sink.pixel((int)std::round(x1 + (double)(y - y1) * k), y, 255);
+        }
+    }
+}
+
+void raster::step_line(PixelSink& sink, int x1, int y1, int x2, int y2)
+{
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    if (dx == 0 && dy == 0) { sink.pixel(x1, y1, 255); return; }
+
+    if (std::abs(dx) >= std::abs(dy)) {
+        if (x1 > x2) { std::swap(x1, x2); std::swap(y1, y2); }
+        affine_runs(sink, true, x1, 1, y1, (double)(y2 - y1) / (x2 - x1), 0, x2 - x1);
+    } else {
+        if (y1 > y2) { std::swap(x1, x2); std::swap(y1, y2); }
+        affine_runs(sink, false, y1, 1, x1, (double)(x2 - x1) / (y2 - y1), 0, y2 - y1);
+    }
+}
+
+void raster::step_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip)
+{
+    if (clip.empty()) return;
+    // Разности - в int64: отрезок далеко за холстом может быть длиннее INT_MAX
+    int64_t dx = (int64_t)x2 - x1;
+    int64_t dy = (int64_t)y2 - y1;
+    if (dx == 0 && dy == 0) { if (clip.contains(x1, y1)) sink.pixel(x1, y1, 255); return; }
+
+    if (std::abs(dx) >= std::abs(dy)) {
+        if (x1 > x2) { std::swap(x1, x2); std::swap(y1, y2); dx = -dx; dy = -dy; }
+        affine_runs_clipped(sink, true, x1, 1, y1, (double)dy / dx, dx, clip);
+    } else {
+        if (y1 > y2) { std::swap(x1, x2); std::swap(y1, y2); dx = -dx; dy = -dy; }
+        affine_runs_clipped(sink, false, y1, 1, x1, (double)dx / dy, dy, clip);
+    }
+}
+
+void raster::dda_line_reference(PixelSink& sink, int x1, int y1, int x2, int y2)
+{
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    int steps = std::max(std::abs(dx), std::abs(dy));
+    if (steps == 0) { sink.pixel(x1, y1, 255); return; }
+
+    double x_inc = (double)dx / steps;
+    double y_inc = (double)dy / steps;
+
+    for (int i = 0; i <= steps; ++i) {
+        sink.pixel((int)std::round(x1 + (double)i * x_inc), (int)std::round(y1 + (double)i * y_inc), 255);
+    }
+}
+
+// По основной оси шаг ЦДА равен +-1 точно, поэтому векторно считается только вторая координата.
+void raster::dda_line(PixelSink& sink, int x1, int y1, int x2, int y2)
+{
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    int steps = std::max(std::abs(dx), std::abs(dy));
+    if (steps == 0) { sink.pixel(x1, y1, 255); return; }
+
+    if (std::abs(dx) >= std::abs(dy)) {
+        affine_runs(sink, true, x1, (dx > 0) ? 1 : -1, y1, (double)dy / steps, 0, steps);
+    } else {
+        affine_runs(sink, false, y1, (dy > 0) ? 1 : -1, x1, (double)dx / steps, 0, steps);
+    }
+}
+
+void raster::dda_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip)
+{
+    if (clip.empty()) return;
+    int64_t dx = (int64_t)x2 - x1;
+    int64_t dy = (int64_t)y2 - y1;
+    int64_t steps = std::max(std::abs(dx), std::abs(dy));
+    if (steps == 0) { if (clip.contains(x1, y1)) sink.pixel(x1, y1, 255); return; }
+
+    if (std::abs(dx) >= std::abs(dy)) {
+        affine_runs_clipped(sink, true, x1, (dx > 0) ? 1 : -1, y1, (double)dy / steps, steps, clip);
+    } else {
+        affine_runs_clipped(sink, false, y1, (dy > 0) ? 1 : -1, x1, (double)dx / steps, steps, clip);
+    }
+}
+
+void raster::bresenham_line(PixelSink& sink, int x1, int y1, int x2, int y2)
+{
+    int dx = std::abs(x2 - x1);
+    int dy = std::abs(y2 - y1);
+    int sx = (x1 < x2) ? 1 : -1;
+    int sy = (y1 < y2) ? 1 : -1;
+    int err = dx - dy;
+
+    int x = x1;
+    int y = y1;
+
+    while (true) {
+        sink.pixel(x, y, 255);
+        if (x == x2 && y == y2) break;
+        int e2 = 2 * err;
+        if (e2 > -dy) { err -= dy; x += sx; }
+        if (e2 < dx) { err += dx; y += sy; }
+    }
+}
+
+// Шаги отрезка Брезенхема: k = 0..n по основной оси, число шагов по второй оси
+// до шага k равно f(k) = floor((2 * d_min * k + d_maj - 1) / (2 * d_maj)).
+// Это замкнутая форма условия e2 < dx (e2 > -dy) из bresenham_line.
+void raster::bresenham_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip)
+{
+    if (clip.empty()) return;
+    int64_t dx = std::abs((int64_t)x2 - x1);
+    int64_t dy = std::abs((int64_t)y2 - y1);
+    int sx = (x1 < x2) ? 1 : -1;
+    int sy = (y1 < y2) ? 1 : -1;
+
+    bool x_major = dx >= dy;
+    int64_t d_maj = x_major ? dx : dy;
+    int64_t d_min = x_major ? dy : dx;
+    int maj0 = x_major ? x1 : y1, min0 = x_major ? y1 : x1;
+    int s_maj = x_major ? sx : sy, s_min = x_major ? sy : sx;
+    int maj_lo = x_major ? clip.x0 : clip.y0, maj_hi = x_major ? clip.x1 : clip.y1;
+    int min_lo = x_major ? clip.y0 : clip.x0, min_hi = x_major ? clip.y1 : clip.x1;
+
+    if (d_maj == 0) {
+        if (clip.contains(x1, y1)) sink.pixel(x1, y1, 255);
+        return;
+    }
+
+    // Диапазон шагов по основной оси
+    int64_t k_lo, k_hi;
+    axis_range(maj0, s_maj, d_maj, maj_lo, maj_hi, k_lo, k_hi);
+
+    // Диапазон шагов по второй оси: f(k) в [f_lo, f_hi]
+    int64_t f_lo = (s_min > 0) ? (int64_t)min_lo - min0 : (int64_t)min0 - min_hi;
+    int64_t f_hi = (s_min > 0) ? (int64_t)min_hi - min0 : (int64_t)min0 - min_lo;
+    if (d_min == 0) {
+        if (f_lo > 0 || f_hi < 0) return;
+    } else {
+        wide_t m = d_maj, n = d_min;
+        k_lo = std::max<int64_t>(k_lo, (int64_t)std::max<wide_t>(ceil_div(2 * m * f_lo - m + 1, 2 * n), -1));
+        k_hi = std::min<int64_t>(k_hi, (int64_t)std::min<wide_t>(ceil_div(2 * m * (f_hi + 1) - m + 1, 2 * n) - 1,
+                                                                  d_maj + 1));
+    }
+    if (k_lo > k_hi) return;
+
+    // Состояние на первом видимом шаге; e = 2*d_min*k + d_maj - 1 - 2*d_maj*f в [0, 2*d_maj)
+    wide_t num = (wide_t)2 * d_min * k_lo + d_maj - 1;
+    int64_t f = (int64_t)floor_div(num, (wide_t)2 * d_maj);
+    int64_t e = (int64_t)(num - (wide_t)2 * d_maj * f);
+    int64_t maj = maj0 + s_maj * k_lo;
+    int64_t mn = min0 + s_min * f;
+    SpanKind kind = x_major ? SPAN_HORIZONTAL : SPAN_VERTICAL;
+
+    int64_t run_start = maj;
+    for (int64_t k = k_lo; k <= k_hi; ++k) {
+        bool last = (k == k_hi);
+        e += 2 * d_min;
+        bool step_min = e >= 2 * d_maj;
+        if (last || step_min) {
+            // Серия вдоль основной оси закончилась на текущем шаге
+            int64_t a = std::min(run_start, maj), len = std::abs(maj - run_start) + 1;
+            if (x_major) long_span(sink, kind, a, mn, len); else long_span(sink, kind, mn, a, len);
+            run_start = maj + s_maj;
+        }
+        if (step_min) { e -= 2 * d_maj; mn += s_min; }
+        maj += s_maj;
+    }
+}
+
+void raster::bresenham_circle(PixelSink& sink, int cx, int cy, int radius)
+{
+    int x = 0;
+    int y = radius;
+    int d = 3 - 2 * radius;
+    int run_start = 0;
+    while (x < y) {
+        if (d < 0) d = d + 4 * x + 6;
+        else {
+            d = d + 4 * (x - y) + 10;
+            push_circle_runs(sink, cx, cy, run_start, x, y);
+            run_start = x + 1;
+            y--;
+        }
+        x++;
+    }
+    push_circle_runs(sink, cx, cy, run_start, x, y);
+}
+
+int raster::bresenham_circle_y(int radius, int x)
+{
+    if (radius <= 0) return radius;
+    int64_t y = circle_midpoint_y(radius, x);
+    // На последнем шаге цикл уменьшает y не больше чем на 1
+    if (x > 0) y = std::max(y, circle_midpoint_y(radius, x - 1) - 1);
+    return (int)y;
+}
+
+int raster::bresenham_circle_octant_end(int radius)
+{
+    if (radius <= 0) return 0;
+    // Последний x не дальше r / sqrt(2) + 1
+    int64_t hi = std::min<int64_t>(radius, (int64_t)(radius * 0.7072) + 2);
+    return (int)first_true(0, hi, [&](int64_t x) { return x >= bresenham_circle_y(radius, (int)x); });
+}
+
+// Для каждого октанта видимые точки - отрезок [lo, hi] по x (обе координаты пикселя
+// монотонны по x). Обход идет по объединению этих отрезков с решающей величиной
+// d = 2(x+1)^2 + y^2 + (y-1)^2 - 2r^2, посчитанной сразу для первого x, а серия каждого
+// октанта обрезается по его отрезку, поэтому порядок серий тот же, что в bresenham_circle.
+void raster::bresenham_circle_clipped(PixelSink& sink, int cx, int cy, int radius, const ClipRect& clip)
+{
+    bresenham_circle_clipped(sink, cx, cy, radius, clip, 0, INT_MAX);
+}
+
+void raster::bresenham_circle_visible_x(int cx, int cy, int radius, const ClipRect& clip, int64_t lo[8],
+                                        int64_t hi[8])
+{
+    if (clip.empty()) {
+        std::fill(lo, lo + 8, 0);
+        std::fill(hi, hi + 8, -1);
+        return;
+    }
+    int x_end = bresenham_circle_octant_end(radius);
+    for (int o = 0; o < 8; ++o) circle_octant_range(CIRCLE_OCTANTS[o], cx, cy, radius, x_end, clip, lo[o], hi[o]);
+}
+
+void raster::bresenham_circle_clipped(PixelSink& sink, int cx, int cy, int radius, const ClipRect& clip,
+                                      int x_from, int x_to)
+{
+    if (clip.empty()) return;
+
+    int64_t lo[8], hi[8];
+    bresenham_circle_visible_x(cx, cy, radius, clip, lo, hi);
+    int64_t from = INT64_MAX, to = -1;
+    for (int o = 0; o < 8; ++o) {
+        lo[o] = std::max<int64_t>(lo[o], x_from);
+        hi[o] = std::min<int64_t>(hi[o], x_to);
+        if (lo[o] <= hi[o]) { from = std::min(from, lo[o]); to = std::max(to, hi[o]); }
+    }
+    if (from > to) return;
+
+    auto push = [&](int64_t x0, int64_t x1, int64_t y) {
+        for (int o = 0; o < 8; ++o) {
+            int64_t a = std::max(x0, lo[o]), b = std::min(x1, hi[o]);
+            if (a > b) continue;
+            const CircleOctant& oct = CIRCLE_OCTANTS[o];
+            int len = (int)(b - a + 1);
+            int start = (int)((oct.sa > 0) ? a : -b);
+            int across = (int)(oct.sb * y);
+            if (oct.swap) sink.span(SPAN_VERTICAL, cx + across, cy + start, len);
+            else sink.span(SPAN_HORIZONTAL, cx + start, cy + across, len);
+        }
+    };
+
+    int64_t r = radius;
+    int64_t y = bresenham_circle_y(radius, (int)from);
+    int64_t d = 2 * (from + 1) * (from + 1) - (r - y) * (r + y) - (r - y + 1) * (r + y - 1);
+    int64_t run_start = from;
+    for (int64_t x = from; x < to; ++x) {
+        if (d < 0) d = d + 4 * x + 6;
+        else {
+            d = d + 4 * (x - y) + 10;
+            push(run_start, x, y);
+            run_start = x + 1;
+            y--;
+        }
+    }
+    push(run_start, to, y);
+}
+
+// Алгоритм Кастла-Питвея (Лингвистический/Евклидов)
+// Цепочки m1/m2 не строятся строками: каждая хранится узлом "child^rep, затем tail"
+// в массиве фиксированного размера, а серия одинаковых вычитаний алгоритма Евклида
+// сворачивается в одно деление. Узлов O(log n), проход выдает серии вдоль основной оси.
+void raster::castle_pitteway_line(PixelSink& sink, int x1, int y1, int x2, int y2)
+{
+    int64_t dx = (int64_t)x2 - x1;
+    int64_t dy = (int64_t)y2 - y1;
+
+    int sx = (dx >= 0) ? 1 : -1;
+    int sy = (dy >= 0) ? 1 : -1;
+
+    int64_t a = std::abs(dx);
+    int64_t b = std::abs(dy);
+
+    bool steep = b > a;
+    if (steep) std::swap(a, b);
+
+    const int S = CastleChain::S, D = CastleChain::D;
+    CastleChain chain;
+    build_castle_chain(a, b, chain);
+    const CastleChain::Node* nodes = chain.nodes;
+
+    // u - шаг по основной оси, v - по второй; серия [u0, u] на строке v
+    auto emit = [&sink, steep, x1, y1, sx, sy](int64_t u0, int64_t u, int64_t v) {
+        int64_t len = u - u0 + 1;
+        if (steep) long_span(sink, SPAN_VERTICAL, x1 + sx * v, std::min(y1 + sy * u0, y1 + sy * u), len);
+        else long_span(sink, SPAN_HORIZONTAL, std::min(x1 + sx * u0, x1 + sx * u), y1 + sy * v, len);
+    };
+    int64_t u = 0, v = 0, u0 = 0;
+    auto leaf = [&](int n, int64_t times) {
+        if (n == S) { u += times; return; }
+        for (; times > 0; --times) {
+            emit(u0, u, v);
+            u0 = ++u;
+            ++v;
+        }
+    };
+
+    // Обход без рекурсии: глубина стека не больше числа узлов
+    struct Frame { int node; int64_t left; };
+    Frame stack[CastleChain::MAX_NODES];
+    int depth = 0;
+    auto enter = [&](int n) {
+        if (n <= D) { leaf(n, 1); return; }
+        const CastleChain::Node& node = nodes[n];
+        if (node.child <= D && node.tail <= D) {   // нижний уровень - без стека
+            leaf(node.child, node.rep);
+            if (node.tail >= 0) leaf(node.tail, 1);
+        } else {
+            stack[depth++] = {n, node.rep};
+        }
+    };
+
+    enter(chain.root);
+    while (depth > 0) {
+        Frame& f = stack[depth - 1];
+        const CastleChain::Node& n = nodes[f.node];
+        if (f.left > 0) {
+            if (n.child <= D) { leaf(n.child, f.left); f.left = 0; }  // серия s или d целиком
+            else { --f.left; enter(n.child); }
+        } else {
+            --depth;
+            if (n.tail >= 0) enter(n.tail);
+        }
+    }
+    emit(u0, u, v);
+}
+
+// Для отсечения у каждого узла известно, на сколько шагов по обеим осям сдвигает его цепочка:
+// цепочки (и повторы child) целиком до видимой части пропускаются без обхода, проход
+// останавливается, как только вышел за clip. Серии на границе обрезаются.
+void raster::castle_pitteway_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip)
+{
+    if (clip.empty()) return;
+    int64_t dx = (int64_t)x2 - x1;
+    int64_t dy = (int64_t)y2 - y1;
+
+    int sx = (dx >= 0) ? 1 : -1;
+    int sy = (dy >= 0) ? 1 : -1;
+
+    int64_t a = std::abs(dx);
+    int64_t b = std::abs(dy);
+
+    bool steep = b > a;
+    if (steep) std::swap(a, b);
+
+    // Видимые шаги: u по основной оси, v по второй
+    int64_t u_lo, u_hi, v_lo, v_hi;
+    axis_range(steep ? y1 : x1, steep ? sy : sx, a, steep ? clip.y0 : clip.x0, steep ? clip.y1 : clip.x1, u_lo, u_hi);
+    axis_range(steep ? x1 : y1, steep ? sx : sy, b, steep ? clip.x0 : clip.y0, steep ? clip.x1 : clip.y1, v_lo, v_hi);
+    if (u_lo > u_hi || v_lo > v_hi) return;
+
+    const int S = CastleChain::S, D = CastleChain::D;
+    CastleChain chain;
+    build_castle_chain(a, b, chain);
+    const CastleChain::Node* nodes = chain.nodes;
+
+    // Сдвиг цепочки каждого узла по осям (дети построены раньше родителей)
+    int64_t len_u[CastleChain::MAX_NODES], len_v[CastleChain::MAX_NODES];
+    len_u[S] = 1; len_v[S] = 0;
+    len_u[D] = 1; len_v[D] = 1;
+    for (int n = 2; n < chain.count; ++n) {
+        const CastleChain::Node& node = nodes[n];
+        len_u[n] = node.rep * len_u[node.child] + ((node.tail >= 0) ? len_u[node.tail] : 0);
+        len_v[n] = node.rep * len_v[node.child] + ((node.tail >= 0) ? len_v[node.tail] : 0);
+    }
+
+    // Серия [u0, u] на строке v, обрезанная по видимым шагам
+    auto emit = [&](int64_t u0, int64_t u, int64_t v) {
+        if (v < v_lo || v > v_hi) return;
+        u0 = std::max(u0, u_lo);
+        u = std::min(u, u_hi);
+        if (u0 > u) return;
+        int64_t len = u - u0 + 1;
+        if (steep) long_span(sink, SPAN_VERTICAL, x1 + sx * v, std::min(y1 + sy * u0, y1 + sy * u), len);
+        else long_span(sink, SPAN_HORIZONTAL, std::min(x1 + sx * u0, x1 + sx * u), y1 + sy * v, len);
+    };
+    int64_t u = 0, v = 0, u0 = 0;
+    bool done = false; // вышли за clip
+    auto leaf = [&](int n, int64_t times) {
+        if (n == S) { u += times; done = u > u_hi; return; }
+        for (; times > 0; --times) {
+            emit(u0, u, v);
+            u0 = ++u;
+            ++v;
+            if (u > u_hi || v > v_hi) { done = true; return; }
+            // Невидимые одиночные шаги d перед clip пропускаются сразу
+            int64_t skip = std::min<int64_t>(times - 1, std::max<int64_t>(0, std::max(u_lo - u, v_lo - v)));
+            u += skip; v += skip; u0 = u;
+            times -= skip;
+        }
+    };
+    // Цепочка узла целиком до видимой части: сдвиг без обхода
+    auto skip_chain = [&](int n) {
+        if (u + len_u[n] >= u_lo && v + len_v[n] >= v_lo) return false;
+        u += len_u[n];
+        v += len_v[n];
+        if (len_v[n]) u0 = u; // серия началась где-то внутри цепочки, до clip
+        return true;
+    };
+
+    struct Frame { int node; int64_t left; };
+    Frame stack[CastleChain::MAX_NODES];
+    int depth = 0;
+    auto enter = [&](int n) {
+        if (n <= D) { leaf(n, 1); return; }
+        if (skip_chain(n)) return;
+        const CastleChain::Node& node = nodes[n];
+        if (node.child <= D && node.tail <= D) {
+            leaf(node.child, node.rep);
+            if (node.tail >= 0 && !done) leaf(node.tail, 1);
+        } else {
+            stack[depth++] = {n, node.rep};
+        }
+    };
+
+    enter(chain.root);
+    while (depth > 0 && !done) {
+        Frame& f = stack[depth - 1];
+        const CastleChain::Node& n = nodes[f.node];
+        if (f.left > 0) {
+            if (n.child <= D) { leaf(n.child, f.left); f.left = 0; continue; }
+            if (u < u_lo || v < v_lo) {
+                // Повторы child, целиком лежащие до clip
+                int64_t lu = len_u[n.child], lv = len_v[n.child];
+                int64_t k = (u < u_lo) ? (u_lo - u - 1) / lu : 0;
+                if (v < v_lo) k = std::max<int64_t>(k, (lv == 0) ? f.left : (v_lo - v - 1) / lv);
+                k = std::min<int64_t>(k, f.left);
+                if (k > 0) {
+                    u += k * lu;
+                    v += k * lv;
+                    if (lv) u0 = u;
+                    f.left -= k;
+                    continue;
+                }
+            }
+            --f.left;
+            enter(n.child);
+        } else {
+            --depth;
+            if (n.tail >= 0) enter(n.tail);
+        }
+    }
+    emit(u0, u, v);
+}
+
+// Сглаживание (Алгоритм Ву)
+// Целочисленный вариант: y в формате 16.16 с точным остатком,
+// покрытие - старшие 8 бит дробной части. Каждый столбец - одна пара пикселей.
+// Концы целые, отрезок начинается и кончается в центре пикселя: оба конца покрыты
+// по длине наполовину (128), как xgap = 0.5 в исходном алгоритме.
+void raster::wu_line(PixelSink& sink, int x1, int y1, int x2, int y2)
+{
+    wu_line_clipped(sink, x1, y1, x2, y2, {INT_MIN, INT_MIN, INT_MAX, INT_MAX});
+}
+
+void raster::wu_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip)
+{
+    if (clip.empty()) return;
+
+    bool steep = std::abs((int64_t)y2 - y1) > std::abs((int64_t)x2 - x1);
+    if (steep) { std::swap(x1, y1); std::swap(x2, y2); }
+    if (x1 > x2) { std::swap(x1, x2); std::swap(y1, y2); }
+
+    // В повернутой системе: основная ось - x, вторая - y; пара идет вдоль y
+    int lo = steep ? clip.y0 : clip.x0, hi = steep ? clip.y1 : clip.x1;
+    int min_lo = steep ? clip.x0 : clip.y0, min_hi = steep ? clip.x1 : clip.y1;
+    SpanKind pair_kind = steep ? SPAN_HORIZONTAL : SPAN_VERTICAL;
+    auto plot_pair = [&](int x, int y, uint8_t a0, uint8_t a1) {
+        if (x < lo || x > hi) return;
+        // Половина пары с нулевым покрытием не выдается: в буфере команд она заняла бы команду
+        bool in0 = a0 && y >= min_lo && y <= min_hi;
+        bool in1 = a1 && (int64_t)y + 1 >= min_lo && (int64_t)y + 1 <= min_hi;
+        if (in0 && in1) {
+            if (steep) sink.pixel_pair(pair_kind, y, x, a0, a1); else sink.pixel_pair(pair_kind, x, y, a0, a1);
+        } else if (in0) {
+            if (steep) sink.pixel(y, x, a0); else sink.pixel(x, y, a0);
+        } else if (in1) {
+            if (steep) sink.pixel(y + 1, x, a1); else sink.pixel(x, y + 1, a1);
+        }
+    };
+
+    int64_t dx = (int64_t)x2 - x1;
+    int64_t dy = (int64_t)y2 - y1;
+
+    plot_pair(x1, y1, 128, 0);
+    if (dx == 0) return;
+    plot_pair(x2, y2, 128, 0);
+
+    // y(k) = y1 + floor(dy * k * 2^16 / dx) в 16.16: шаг - частное, остаток
+    // копится как ошибка Брезенхема, поэтому погрешность не растет с длиной
+    int64_t from = std::max<int64_t>((int64_t)x1 + 1, lo);
+    int64_t to = std::min<int64_t>((int64_t)x2 - 1, hi);
+    if (from > to) return;
+    int64_t step_num = dy * 65536;
+    int64_t gradient = floor_div(step_num, dx);
+    int64_t rem = step_num - gradient * dx;
+    wide_t num = (wide_t)step_num * (from - x1); // до 2^80 при разностях около 2^32
+    int64_t offset = (int64_t)floor_div(num, (wide_t)dx);
+    int64_t err = (int64_t)(num - (wide_t)offset * dx);
+    int64_t intery = (int64_t)y1 * 65536 + offset;
+    for (int64_t x = from; x <= to; x++) {
+        int iy = (int)(intery >> 16);
+        uint8_t upper = (uint8_t)((intery >> 8) & 0xFF);
+        plot_pair((int)x, iy, (uint8_t)(255 - upper), upper);
+        intery += gradient;
+        err += rem;
+        if (err >= dx) { err -= dx; ++intery; }
+    }
+}
+
+// Кривые Безье (Квадратичная)
+void raster::bezier_quadratic_reference(PixelSink& sink, int x1, int y1, int cx, int cy, int x2, int y2)
+{
+    int steps = std::max(std::abs(x2-x1), std::abs(y2-y1)) + std::max(std::abs(cx-x1), std::abs(cy-y1));
+    if (steps == 0) steps = 1;
+
+    for (int i = 0; i <= steps; i++) {
+        double t = (double)i / steps;
+        double u = 1 - t;
+        double x = u*u*x1 + 2*u*t*cx + t*t*x2;
+        double y = u*u*y1 + 2*u*t*cy + t*t*y2;
+
+        sink.pixel((int)std::round(x), (int)std::round(y), 255);
+    }
+}
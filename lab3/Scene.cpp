@@ -0,0 +1,265 @@
+#include "rasterscene.hpp"
+#include "rasterfill.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char raster::SCENE_MAGIC[8] = {'R', 'S', 'C', 'E', 'N', 'E', '\r', '\n'};
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    const int DEFAULT_SIZE = 1024;
+
+    /**
+     * @brief Команда текстового варианта: число аргументов и вид примитива
+     * (kind < 0 - служебные команды size и color).
+     */
+    struct TextCommand
+    {
+        const char* name;
+        int kind;
+        int args;
+    };
+
+    const int CMD_SIZE = -1;
+    const int CMD_COLOR = -2;
+
+    const TextCommand TEXT_COMMANDS[] = {
+        {"size", CMD_SIZE, 2},
+        {"color", CMD_COLOR, 3},
+        {"line", (int)raster::PrimitiveKind::Line, 4},
+        {"circle", (int)raster::PrimitiveKind::Circle, 3},
+        {"quad", (int)raster::PrimitiveKind::Quad, 6},
+        {"cubic", (int)raster::PrimitiveKind::Cubic, 8},
+        {"fill_circle", (int)raster::PrimitiveKind::FillCircle, 3},
+        {"triangle", (int)raster::PrimitiveKind::FillTriangle, 6},
+    };
+
+    bool fail(std::string* error, const std::string& message)
+    {
+        if (error) *error = message;
+        return false;
+    }
+
+    std::string system_error(const std::string& path)
+    {
+        return path + ": " + std::strerror(errno);
+    }
+
+    inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+} // namespace
+
+raster::Scene::~Scene()
+{
+    release();
+}
+
+void raster::Scene::release()
+{
+    if (m_map) munmap(m_map, m_map_size);
+    m_map = nullptr;
+    m_map_size = 0;
+    m_parsed.clear();
+    m_data = nullptr;
+    m_count = 0;
+    m_width = m_height = 0;
+}
+
+bool raster::Scene::load(const std::string& path, std::string* error)
+{
+    release();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail(error, system_error(path));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::string message = system_error(path);
+        close(fd);
+        return fail(error, message);
+    }
+    size_t size = (size_t)st.st_size;
+
+    // Двоичная сцена: отображение живет до release(), примитивы читаются прямо из него
+    char magic[sizeof(SCENE_MAGIC)] = {};
+    bool binary = size >= sizeof(SceneHeader) && pread(fd, magic, sizeof(magic), 0) == (ssize_t)sizeof(magic) &&
+                  std::memcmp(magic, SCENE_MAGIC, sizeof(magic)) == 0;
+    if (binary) {
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        std::string message = system_error(path);
+        close(fd);
+        if (map == MAP_FAILED) return fail(error, message);
+        m_map = map;
+        m_map_size = size;
+        madvise(map, size, MADV_SEQUENTIAL);
+
+        SceneHeader header;
+        std::memcpy(&header, map, sizeof(header));
+        if (header.version != SCENE_VERSION) {
+            release();
+            return fail(error, path + ": unsupported scene version " + std::to_string(header.version));
+        }
+        if (header.width < 1 || header.width > 32768 || header.height < 1 || header.height > 32768) {
+            release();
+            return fail(error, path + ": bad canvas size");
+        }
+        if (header.count > (size - sizeof(SceneHeader)) / sizeof(ScenePrimitive)) {
+            release();
+            return fail(error, path + ": truncated scene");
+        }
+        m_width = (int)header.width;
+        m_height = (int)header.height;
+        m_count = (size_t)header.count;
+        m_data = reinterpret_cast<const ScenePrimitive*>(static_cast<const char*>(map) + sizeof(SceneHeader));
+        return true;
+    }
+
+    std::string text(size, '\0');
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, &text[done], size - done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    close(fd);
+    text.resize(done);
+
+    if (!parse_text(text, error)) {
+        if (error) *error = path + ":" + *error;
+        release();
+        return false;
+    }
+    return true;
+}
+
+bool raster::Scene::parse_text(const std::string& text, std::string* error)
+{
+    m_width = m_height = DEFAULT_SIZE;
+    ScenePrimitive current = {PrimitiveKind::Line, 0, 0, 0, {}};
+
+    const char* p = text.c_str();
+    for (int line = 1; *p; ++line) {
+        while (is_blank(*p)) ++p;
+        const char* word = p;
+        while ((*p >= 'a' && *p <= 'z') || *p == '_') ++p;
+        size_t word_len = (size_t)(p - word);
+
+        if (word_len > 0) {
+            const TextCommand* cmd = nullptr;
+            for (const TextCommand& c : TEXT_COMMANDS)
+                if (std::strlen(c.name) == word_len && std::strncmp(c.name, word, word_len) == 0) cmd = &c;
+            if (!cmd) return fail(error, std::to_string(line) + ": unknown command '" + std::string(word, word_len) + "'");
+
+            long args[8];
+            for (int i = 0; i < cmd->args; ++i) {
+                while (is_blank(*p)) ++p;
+                char* next = nullptr;
+                args[i] = std::strtol(p, &next, 10);
+                if (next == p || args[i] < -32768 || args[i] > 32767)
+                    return fail(error, std::to_string(line) + ": '" + cmd->name + "' expects " +
+                                           std::to_string(cmd->args) + " integers in [-32768, 32767]");
+                p = next;
+            }
+
+            if (cmd->kind == CMD_SIZE) {
+                if (args[0] < 1 || args[0] > 32768 || args[1] < 1 || args[1] > 32768)
+                    return fail(error, std::to_string(line) + ": canvas size must be in [1, 32768]");
+                m_width = (int)args[0];
+                m_height = (int)args[1];
+            } else if (cmd->kind == CMD_COLOR) {
+                for (int i = 0; i < 3; ++i)
+                    if (args[i] < 0 || args[i] > 255) return fail(error, std::to_string(line) + ": color must be in [0, 255]");
+                current.r = (uint8_t)args[0];
+                current.g = (uint8_t)args[1];
+                current.b = (uint8_t)args[2];
+            } else {
+                ScenePrimitive prim = current;
+                prim.kind = (PrimitiveKind)cmd->kind;
+                for (int i = 0; i < cmd->args; ++i) prim.v[i] = (int16_t)args[i];
+                m_parsed.push_back(prim);
+            }
+        }
+
+        while (is_blank(*p)) ++p;
+        if (*p == '#') while (*p && *p != '\n') ++p;
+        if (*p && *p != '\n') return fail(error, std::to_string(line) + ": unexpected '" + std::string(1, *p) + "'");
+        if (*p) ++p;
+    }
+
+    m_data = m_parsed.data();
+    m_count = m_parsed.size();
+    return true;
+}
+
+bool raster::save_scene(const std::string& path, int width, int height, const ScenePrimitive* primitives, size_t count,
+                        std::string* error)
+{
+    SceneHeader header = {};
+    std::memcpy(header.magic, SCENE_MAGIC, sizeof(header.magic));
+    header.version = SCENE_VERSION;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.count = count;
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return fail(error, system_error(path));
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(primitives, sizeof(ScenePrimitive), count, f) == count;
+    ok = (std::fclose(f) == 0) && ok;
+    return ok ? true : fail(error, system_error(path));
+}
+
+void raster::render_scene(Framebuffer& fb, const Scene& scene, SceneLineAlgorithm algorithm, BlendMode mode)
+{
+    FramebufferSink sink(fb);
+    sink.set_blend_mode(mode);
+    ClipRect clip = {0, 0, fb.width() - 1, fb.height() - 1};
+
+    // Цвет меняется редко: соседние примитивы обычно одного цвета
+    Rgba8 color = {0, 0, 0, 255};
+    sink.set_color(color);
+
+    for (const ScenePrimitive& p : scene) {
+        if (p.r != color.r || p.g != color.g || p.b != color.b) {
+            color = {p.r, p.g, p.b, 255};
+            sink.set_color(color);
+        }
+        const int16_t* v = p.v;
+        switch (p.kind) {
+        case PrimitiveKind::Line:
+            switch (algorithm) {
+            case SceneLineAlgorithm::Step: step_line_clipped(sink, v[0], v[1], v[2], v[3], clip); break;
+            case SceneLineAlgorithm::DDA: dda_line_clipped(sink, v[0], v[1], v[2], v[3], clip); break;
+            case SceneLineAlgorithm::Bresenham: bresenham_line_clipped(sink, v[0], v[1], v[2], v[3], clip); break;
+            case SceneLineAlgorithm::Wu: wu_line_clipped(sink, v[0], v[1], v[2], v[3], clip); break;
+            case SceneLineAlgorithm::Castle: castle_pitteway_line_clipped(sink, v[0], v[1], v[2], v[3], clip); break;
+            }
+            break;
+        case PrimitiveKind::Circle:
+            bresenham_circle_clipped(sink, v[0], v[1], v[2], clip);
+            break;
+        case PrimitiveKind::Quad:
+            bezier_quadratic_clipped(sink, v[0], v[1], v[2], v[3], v[4], v[5], clip);
+            break;
+        case PrimitiveKind::Cubic:
+            bezier_cubic_clipped(sink, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], clip);
+            break;
+        case PrimitiveKind::FillCircle:
+            fill_circle(sink, v[0], v[1], v[2], clip);
+            break;
+        case PrimitiveKind::FillTriangle: {
+            PointD tri[3] = {{(double)v[0], (double)v[1]}, {(double)v[2], (double)v[3]}, {(double)v[4], (double)v[5]}};
+            fill_polygon(sink, tri, 3, FillRule::NonZero, clip);
+            break;
+        }
+        }
+    }
+}
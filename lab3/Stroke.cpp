@@ -0,0 +1,210 @@
+#include "rasterstroke.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    using raster::PointD;
+
+    const double PI = 3.14159265358979323846;
+    // Наибольшее число хорд на дугу: дальше хорды короче пикселя при любой разумной ширине
+    const int MAX_ARC_PARTS = 1024;
+
+    inline PointD operator+(PointD a, PointD b) { return {a.x + b.x, a.y + b.y}; }
+    inline PointD operator-(PointD a, PointD b) { return {a.x - b.x, a.y - b.y}; }
+    inline PointD operator*(PointD a, double k) { return {a.x * k, a.y * k}; }
+    inline double dot(PointD a, PointD b) { return a.x * b.x + a.y * b.y; }
+    inline double cross(PointD a, PointD b) { return a.x * b.y - a.y * b.x; }
+
+    /**
+     * @brief Многоугольник pts[0..n) подконтуром out с положительной ориентацией:
+     * при одинаковой ориентации всех частей NonZero закрашивает их объединение.
+     */
+    void add_piece(raster::Polyline& out, const PointD* pts, size_t n)
+    {
+        double area = 0;
+        for (size_t i = 0; i < n; ++i) area += cross(pts[i], pts[(i + 1) % n]);
+        if (area == 0) return; // вырожденная часть ничего не закрашивает
+        out.starts.push_back((uint32_t)out.points.size());
+        out.closed.push_back(1);
+        if (area > 0) out.points.insert(out.points.end(), pts, pts + n);
+        else out.points.insert(out.points.end(), std::make_reverse_iterator(pts + n), std::make_reverse_iterator(pts));
+    }
+
+    /**
+     * @brief Число хорд дуги радиуса r с углом sweep, отходящих от нее не больше чем на tolerance.
+     */
+    int arc_parts(double r, double sweep, double tolerance)
+    {
+        double step = (r > tolerance) ? 2 * std::acos(1 - tolerance / r) : PI / 2;
+        double n = std::ceil(std::abs(sweep) / step);
+        if (!(n >= 1)) return 1;
+        return (int)std::min<double>(n, MAX_ARC_PARTS);
+    }
+
+    /**
+     * @brief Сектор круга с центром c от вектора from (длины r) на угол sweep.
+     */
+    void add_sector(raster::Polyline& out, PointD c, PointD from, double sweep, double tolerance)
+    {
+        thread_local std::vector<PointD> pts;
+        double r = std::sqrt(dot(from, from));
+        int n = arc_parts(r, sweep, tolerance);
+        double a0 = std::atan2(from.y, from.x);
+        pts.clear();
+        pts.push_back(c);
+        for (int i = 0; i <= n; ++i) {
+            double a = a0 + sweep * i / n;
+            pts.push_back({c.x + r * std::cos(a), c.y + r * std::sin(a)});
+        }
+        add_piece(out, pts.data(), pts.size());
+    }
+
+    /**
+     * @brief Угол от a к b (по модулю не больше pi); при развороте на pi - через сторону toward.
+     */
+    double sweep_between(PointD a, PointD b, PointD toward)
+    {
+        double sweep = std::atan2(cross(a, b), dot(a, b));
+        double mid = std::atan2(a.y, a.x) + sweep / 2;
+        if (std::abs(std::abs(sweep) - PI) < 1e-9 && std::cos(mid) * toward.x + std::sin(mid) * toward.y < 0)
+            sweep = -sweep;
+        return sweep;
+    }
+
+    /**
+     * @brief Левая нормаль отрезка a -> b длины hw и единичное направление.
+     */
+    void segment_frame(PointD a, PointD b, double hw, PointD& dir, PointD& normal)
+    {
+        PointD d = b - a;
+        double len = std::sqrt(dot(d, d));
+        dir = d * (1 / len);
+        normal = PointD{-dir.y, dir.x} * hw;
+    }
+
+    void add_segment(raster::Polyline& out, PointD a, PointD b, PointD n)
+    {
+        PointD quad[4] = {a + n, b + n, b - n, a - n};
+        add_piece(out, quad, 4);
+    }
+
+    /**
+     * @brief Стык в вершине p отрезков с направлениями d0 -> d1 и нормалями n0, n1:
+     * закрывает клин между краями отрезков с внешней стороны поворота.
+     */
+    void add_join(raster::Polyline& out, PointD p, PointD d0, PointD n0, PointD d1, PointD n1,
+                  const raster::StrokeStyle& style)
+    {
+        double turn = cross(d0, d1);
+        double cos_theta = dot(d0, d1);
+        if (std::abs(turn) < 1e-12 && cos_theta > 0) return; // продолжение прямой
+        double s = (turn > 0) ? -1 : 1;                      // внешняя сторона - против поворота
+        PointD a = n0 * s, b = n1 * s;
+
+        if (style.join == raster::LineJoin::Round) {
+            add_sector(out, p, a, sweep_between(a, b, d0), style.tolerance);
+            return;
+        }
+        if (style.join == raster::LineJoin::Miter && 1 + cos_theta > 1e-12) {
+            // Острие на биссектрисе: |m| = hw / cos(theta / 2), отношение к hw ограничено miter_limit
+            double ratio = std::sqrt(2 / (1 + cos_theta));
+            if (ratio <= style.miter_limit) {
+                PointD m = p + (a + b) * (1 / (1 + cos_theta));
+                PointD quad[4] = {p, p + a, m, p + b};
+                add_piece(out, quad, 4);
+                return;
+            }
+        }
+        PointD tri[3] = {p, p + a, p + b};
+        add_piece(out, tri, 3);
+    }
+
+    /**
+     * @brief Конец в точке p, out_dir - единичное направление наружу, n - нормаль длины hw.
+     */
+    void add_cap(raster::Polyline& out, PointD p, PointD out_dir, PointD n, double hw, const raster::StrokeStyle& style)
+    {
+        if (style.cap == raster::LineCap::Square) {
+            PointD e = out_dir * hw;
+            PointD quad[4] = {p + n, p + n + e, p - n + e, p - n};
+            add_piece(out, quad, 4);
+        } else if (style.cap == raster::LineCap::Round) {
+            add_sector(out, p, n, sweep_between(n, n * -1, out_dir), style.tolerance);
+        }
+    }
+} // namespace
+
+void raster::stroke_outline(const Polyline& lines, const StrokeStyle& style, Polyline& out)
+{
+    out.clear();
+    double hw = style.width / 2;
+    if (!(hw > 0)) return;
+
+    thread_local std::vector<PointD> pts;
+    for (size_t c = 0; c < lines.contours(); ++c) {
+        // Вершины без повторов подряд (и без повтора первой в конце замкнутого)
+        pts.clear();
+        for (uint32_t i = lines.starts[c]; i < lines.end(c); ++i) {
+            const PointD& p = lines.points[i];
+            if (pts.empty() || p.x != pts.back().x || p.y != pts.back().y) pts.push_back(p);
+        }
+        bool closed = lines.closed[c] != 0;
+        if (closed && pts.size() > 1 && pts.front().x == pts.back().x && pts.front().y == pts.back().y) pts.pop_back();
+        if (pts.empty()) continue;
+
+        size_t n = pts.size();
+        if (n == 1) {
+            // Точка: круг или квадрат по виду конца
+            PointD p = pts[0];
+            if (style.cap == LineCap::Round) add_sector(out, p, {hw, 0}, 2 * PI, style.tolerance);
+            else if (style.cap == LineCap::Square) {
+                PointD sq[4] = {{p.x - hw, p.y - hw}, {p.x + hw, p.y - hw}, {p.x + hw, p.y + hw}, {p.x - hw, p.y + hw}};
+                add_piece(out, sq, 4);
+            }
+            continue;
+        }
+
+        size_t segments = closed ? n : n - 1;
+        PointD first_dir = {0, 0}, first_n = {0, 0}, prev_dir = {0, 0}, prev_n = {0, 0};
+        for (size_t i = 0; i < segments; ++i) {
+            PointD a = pts[i], b = pts[(i + 1) % n];
+            PointD dir, normal;
+            segment_frame(a, b, hw, dir, normal);
+            add_segment(out, a, b, normal);
+            if (i == 0) { first_dir = dir; first_n = normal; }
+            else add_join(out, a, prev_dir, prev_n, dir, normal, style);
+            prev_dir = dir;
+            prev_n = normal;
+        }
+        if (closed) {
+            add_join(out, pts[0], prev_dir, prev_n, first_dir, first_n, style);
+        } else {
+            add_cap(out, pts[0], first_dir * -1, first_n, hw, style);
+            add_cap(out, pts[n - 1], prev_dir, prev_n, hw, style);
+        }
+    }
+}
+
+void raster::stroke_polyline(PixelSink& sink, const Polyline& lines, const StrokeStyle& style, const ClipRect& clip,
+                             bool antialias)
+{
+    // Контур переиспользуется между вызовами, как буферы разбиения кривых
+    thread_local Polyline outline;
+    stroke_outline(lines, style, outline);
+    fill_polyline(sink, outline, FillRule::NonZero, clip, antialias);
+}
+
+void raster::stroke_path(PixelSink& sink, const Path& path, const StrokeStyle& style, const ClipRect& clip,
+                         bool antialias)
+{
+    thread_local Polyline lines;
+    flatten_path(path, style.tolerance, lines);
+    stroke_polyline(sink, lines, style, clip, antialias);
+}
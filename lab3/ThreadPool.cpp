@@ -0,0 +1,130 @@
+#include "rasterbatch.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+/**
+ * @brief Внутреннее (анонимное) пространство имен для вспомогательных функций.
+ */
+namespace
+{
+    inline uint64_t pack_range(uint32_t begin, uint32_t end) { return ((uint64_t)begin << 32) | end; }
+
+    /**
+     * @brief Берет очередной индекс с начала своего диапазона.
+     */
+    bool pop_front(std::atomic<uint64_t>& bounds, uint32_t& item)
+    {
+        uint64_t cur = bounds.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t begin = (uint32_t)(cur >> 32), end = (uint32_t)cur;
+            if (begin >= end) return false;
+            if (bounds.compare_exchange_weak(cur, pack_range(begin + 1, end), std::memory_order_acquire)) {
+                item = begin;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @brief Забирает половину (с округлением вверх) остатка чужого диапазона с конца.
+     */
+    bool steal_half(std::atomic<uint64_t>& bounds, uint32_t& begin_out, uint32_t& end_out)
+    {
+        uint64_t cur = bounds.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t begin = (uint32_t)(cur >> 32), end = (uint32_t)cur;
+            if (begin >= end) return false;
+            uint32_t split = end - (end - begin + 1) / 2;
+            if (bounds.compare_exchange_weak(cur, pack_range(begin, split), std::memory_order_acquire)) {
+                begin_out = split;
+                end_out = end;
+                return true;
+            }
+        }
+    }
+} // namespace
+
+
+raster::ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    m_count = threads;
+    m_ranges.reset(new WorkRange[m_count]);
+    for (unsigned i = 1; i < m_count; ++i) m_threads.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+raster::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_threads) t.join();
+}
+
+void raster::ThreadPool::parallel_for(size_t count, const std::function<void(size_t, unsigned)>& fn)
+{
+    if (count == 0) return;
+    assert(count <= UINT32_MAX);
+
+    for (unsigned i = 0; i < m_count; ++i) {
+        uint32_t begin = (uint32_t)(count * i / m_count);
+        uint32_t end = (uint32_t)(count * (i + 1) / m_count);
+        m_ranges[i].bounds.store(pack_range(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_active = m_count - 1;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    run(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_active == 0; });
+    m_job = nullptr;
+}
+
+void raster::ThreadPool::worker_loop(unsigned id)
+{
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+
+        run(id);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_active == 0) m_done.notify_one();
+    }
+}
+
+void raster::ThreadPool::run(unsigned id)
+{
+    const auto& fn = *m_job;
+    uint32_t item;
+    while (true) {
+        while (pop_front(m_ranges[id].bounds, item)) fn(item, id);
+
+        // Свой диапазон пуст - ищем, у кого забрать
+        bool stolen = false;
+        for (unsigned v = 1; v < m_count && !stolen; ++v) {
+            uint32_t begin, end;
+            if (steal_half(m_ranges[(id + v) % m_count].bounds, begin, end)) {
+                m_ranges[id].bounds.store(pack_range(begin + 1, end), std::memory_order_release);
+                fn(begin, id);
+                stolen = true;
+            }
+        }
+        if (!stolen) return;
+    }
+}
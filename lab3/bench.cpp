@@ -0,0 +1,227 @@
+#include "rasterbatch.hpp"
+#include "rasterbench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Замеры алгоритмов без GTK.
+// Для каждой длины строится один и тот же (по --seed) набор случайных отрезков,
+// каждый алгоритм прогревается и повторяется, время - медиана по повторениям.
+
+struct Options {
+    std::vector<int> lengths = {16, 128, 1024};
+    std::vector<double> angles;          // пусто - случайный наклон
+    std::vector<std::string> sinks = {"null", "framebuffer", "tiled", "commands"};
+    std::vector<std::string> algorithms; // пусто - все
+    std::vector<unsigned> threads;       // пусто - 1, 2, 4, ... до числа ядер
+    bool batch = false;
+    raster::BlendMode blend = raster::BlendMode::SourceOver;
+    size_t count = 2000;
+    int warmup = 3;
+    int repetitions = 15;
+    int width = 2048;
+    int height = 2048;
+    uint32_t seed = 42;
+    bool json = false;
+};
+
+static std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+static void print_usage() {
+    std::cerr << "Usage: raster_bench [options]\n"
+              << "  --lengths L1,L2,...   длины отрезков (по умолчанию 16,128,1024)\n"
+              << "  --angles A1,A2,...   наклоны отрезков в градусах (случайные)\n"
+              << "  --count N             отрезков в наборе (2000)\n"
+              << "  --algo a,b,...        step,dda,bresenham,circle,wu,bezier,castle,cubic,fill_circle,fill_polygon,stroke,stroke_wide,step_ref,dda_ref,bezier_ref (все)\n"
+              << "  --sink s,...          null,framebuffer,tiled,commands (все)\n"
+              << "  --warmup N            прогревочных повторений (3)\n"
+              << "  --reps N              замеряемых повторений (15)\n"
+              << "  --size WxH            размер холста (2048x2048)\n"
+              << "  --seed N              зерно генератора (42)\n"
+              << "  --format csv|json     формат вывода (csv)\n"
+              << "  --blend over|replace|add|multiply  режим смешивания приемника framebuffer (over)\n"
+              << "  --batch               пакетная отрисовка по плиткам (bresenham,wu), отрезков/с по числу потоков\n"
+              << "  --threads T1,T2,...   числа потоков для --batch (1,2,4,... до числа ядер)\n";
+}
+
+static bool parse(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (a == "--lengths") { o.lengths.clear(); for (auto& v : split(next())) o.lengths.push_back(std::stoi(v)); }
+            else if (a == "--angles") { o.angles.clear(); for (auto& v : split(next())) o.angles.push_back(std::stod(v)); }
+            else if (a == "--count") o.count = std::stoul(next());
+            else if (a == "--algo") o.algorithms = split(next());
+            else if (a == "--sink") o.sinks = split(next());
+            else if (a == "--warmup") o.warmup = std::stoi(next());
+            else if (a == "--reps") o.repetitions = std::stoi(next());
+            else if (a == "--seed") o.seed = (uint32_t)std::stoul(next());
+            else if (a == "--format") o.json = (next() == "json");
+            else if (a == "--batch") o.batch = true;
+            else if (a == "--blend") {
+                std::string v = next();
+                if (v == "over") o.blend = raster::BlendMode::SourceOver;
+                else if (v == "replace") o.blend = raster::BlendMode::Replace;
+                else if (v == "add") o.blend = raster::BlendMode::Additive;
+                else if (v == "multiply") o.blend = raster::BlendMode::Multiply;
+                else { print_usage(); return false; }
+            }
+            else if (a == "--threads") { for (auto& v : split(next())) o.threads.push_back((unsigned)std::stoul(v)); }
+            else if (a == "--size") {
+                std::string v = next();
+                size_t x = v.find('x');
+                o.width = std::stoi(v.substr(0, x));
+                o.height = std::stoi(v.substr(x + 1));
+            }
+            else { print_usage(); return false; }
+        } catch (...) { print_usage(); return false; }
+    }
+    return o.width > 0 && o.height > 0 && o.repetitions > 0;
+}
+
+static void clear_framebuffer(void* ctx) { static_cast<raster::Framebuffer*>(ctx)->clear(); }
+static void clear_tiled(void* ctx) { static_cast<raster::TiledFramebuffer*>(ctx)->clear(); }
+static void clear_commands(void* ctx) {
+    auto* commands = static_cast<raster::CommandBuffer*>(ctx);
+    commands->clear();
+    commands->set_color(0, 0, 1.0);
+}
+
+// Пакетный режим: один набор отрезков рисуется в буфер кадра пулом из T потоков.
+// Время - на весь набор (раскладка по плиткам входит в замер, очистка - нет).
+static int run_batch(const Options& o) {
+    std::vector<unsigned> threads = o.threads;
+    if (threads.empty()) {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned t = 1; t < hw; t *= 2) threads.push_back(t);
+        threads.push_back(hw);
+    }
+    std::vector<std::string> algorithms = o.algorithms;
+    if (algorithms.empty()) algorithms = {"bresenham", "wu"};
+
+    raster::Framebuffer fb(o.width, o.height);
+    raster::Rgba8 color = raster::rgba8(0, 0, 1.0);
+
+    bool first = true;
+    if (o.json) std::cout << "[\n";
+    else std::cout << "algorithm,threads,length,segments,tile_refs,min_ns,median_ns,p99_ns,segments_per_sec,speedup\n";
+
+    for (int length : o.lengths) {
+        std::vector<raster::Segment> segments = raster::random_segments(o.count, length, o.width, o.height, o.seed);
+
+        for (const std::string& name : algorithms) {
+            raster::BatchAlgorithm algo;
+            if (name == "bresenham") algo = raster::BatchAlgorithm::Bresenham;
+            else if (name == "wu") algo = raster::BatchAlgorithm::Wu;
+            else { std::cerr << "Batch mode supports bresenham,wu: " << name << std::endl; return 1; }
+
+            double base_ns = 0;
+            for (unsigned t : threads) {
+                raster::ThreadPool pool(t);
+                raster::BatchStats bs;
+                std::vector<double> samples;
+                for (int rep = 0; rep < o.warmup + o.repetitions; ++rep) {
+                    fb.clear();
+                    auto start = std::chrono::steady_clock::now();
+                    bs = raster::render_segments(fb, segments.data(), segments.size(), color, algo, pool);
+                    auto end = std::chrono::steady_clock::now();
+                    if (rep >= o.warmup) samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+                }
+                raster::TimingStats st = raster::summarize(samples);
+                if (base_ns == 0) base_ns = st.median_ns;
+                double per_sec = st.median_ns > 0 ? segments.size() * 1e9 / st.median_ns : 0;
+                double speedup = st.median_ns > 0 ? base_ns / st.median_ns : 0;
+
+                if (o.json) {
+                    std::cout << (first ? "  " : ",\n  ") << "{\"algorithm\":\"" << name << "\",\"threads\":" << pool.size()
+                              << ",\"length\":" << length << ",\"segments\":" << segments.size()
+                              << ",\"tile_refs\":" << bs.tile_refs << ",\"min_ns\":" << st.min_ns
+                              << ",\"median_ns\":" << st.median_ns << ",\"p99_ns\":" << st.p99_ns
+                              << ",\"segments_per_sec\":" << per_sec << ",\"speedup\":" << speedup << "}";
+                } else {
+                    std::cout << name << ',' << pool.size() << ',' << length << ',' << segments.size() << ','
+                              << bs.tile_refs << ',' << st.min_ns << ',' << st.median_ns << ',' << st.p99_ns << ','
+                              << per_sec << ',' << speedup << "\n";
+                }
+                first = false;
+            }
+        }
+    }
+    if (o.json) std::cout << "\n]\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parse(argc, argv, o)) return 1;
+    if (o.batch) return run_batch(o);
+
+    raster::CountingSink null_sink;
+    raster::Framebuffer fb(o.width, o.height);
+    raster::FramebufferSink fb_sink(fb);
+    fb_sink.set_color(0, 0, 1.0);
+    fb_sink.set_blend_mode(o.blend);
+    raster::TiledFramebuffer tiled(o.width, o.height);
+    raster::TiledFramebufferSink tiled_sink(tiled);
+    tiled_sink.set_color(0, 0, 1.0);
+    tiled_sink.set_blend_mode(o.blend);
+    raster::CommandBuffer commands;
+
+    bool first = true;
+    if (o.json) std::cout << "[\n"; else std::cout << raster::csv_header() << "\n";
+
+    // Пустой наклон - случайный набор; отрицательные углы передаются как есть
+    std::vector<std::optional<double>> angles(o.angles.begin(), o.angles.end());
+    if (angles.empty()) angles.push_back(std::nullopt);
+
+    for (int length : o.lengths) for (const std::optional<double>& angle : angles) {
+        std::vector<raster::Segment> segments = angle
+            ? raster::sloped_segments(o.count, length, *angle, o.width, o.height, o.seed)
+            : raster::random_segments(o.count, length, o.width, o.height, o.seed);
+
+        for (const raster::BenchAlgorithm& algo : raster::bench_algorithms()) {
+            if (!o.algorithms.empty() && std::find(o.algorithms.begin(), o.algorithms.end(), algo.name) == o.algorithms.end()) continue;
+
+            for (const std::string& sink_name : o.sinks) {
+                raster::BenchResult r;
+                if (sink_name == "null") {
+                    r = raster::run_benchmark(algo, segments, null_sink, "null", o.warmup, o.repetitions);
+                } else if (sink_name == "framebuffer") {
+                    r = raster::run_benchmark(algo, segments, fb_sink, "framebuffer", o.warmup, o.repetitions, clear_framebuffer, &fb);
+                } else if (sink_name == "tiled") {
+                    r = raster::run_benchmark(algo, segments, tiled_sink, "tiled", o.warmup, o.repetitions, clear_tiled, &tiled);
+                } else if (sink_name == "commands") {
+                    r = raster::run_benchmark(algo, segments, commands, "commands", o.warmup, o.repetitions, clear_commands, &commands);
+                } else {
+                    std::cerr << "Unknown sink: " << sink_name << std::endl;
+                    return 1;
+                }
+                r.length = length;
+                r.angle = angle;
+
+                if (o.json) {
+                    std::cout << (first ? "  " : ",\n  ") << raster::to_json(r);
+                } else {
+                    std::cout << raster::to_csv(r) << "\n";
+                }
+                first = false;
+            }
+        }
+    }
+    if (o.json) std::cout << "\n]\n";
+    return 0;
+}
@@ -1,20 +1,30 @@
 #include <gtkmm.h>
 #include <cairomm/cairomm.h>
 #include <vector>
-#include <deque>
 #include <cmath>
 #include <iostream>
 #include <algorithm>
 #include <iomanip>
-#include <chrono>
+#include <optional>
+#include <fstream>
+#include <sstream>
 #include <string>
-
-struct PixelTask {
-    int x;
-    int y;
-    double r, g, b; 
-    double alpha;   
-};
+#include <unordered_map>
+#include "rasteranim.hpp"
+#include "rasterbench.hpp"
+#include "rasterfill.hpp"
+#include "rastergen.hpp"
+#include "rasterlib.hpp"
+#include "rasterstroke.hpp"
+
+// Числа через запятую ("16,128,1024"); пустые элементы пропускаются
+static std::vector<double> parse_numbers(const std::string& text) {
+    std::vector<double> out;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) if (item.find_first_not_of(" ") != std::string::npos) out.push_back(std::stod(item));
+    return out;
+}
 
 class RasterApp : public Gtk::Window {
 public:
@@ -28,27 +38,31 @@ protected:
     void on_resize_clicked();
     void on_draw_real_clicked();
     void on_scale_changed();
+    void on_fit_clicked();
+    void on_bench_clicked();
+    void on_bench_csv_clicked();
     
     bool on_drawing_area_draw(const Cairo::RefPtr<Cairo::Context>& cr);
-    bool on_timeout_step();
+    bool on_area_scroll(GdkEventScroll* event);
+    bool on_area_button_press(GdkEventButton* event);
+    bool on_area_button_release(GdkEventButton* event);
+    bool on_area_motion(GdkEventMotion* event);
+    bool on_tick(const Glib::RefPtr<Gdk::FrameClock>& clock);
 
     // Хелперы
     void clear_canvas_data();
-    void set_pixel_instant(int x, int y, double r, double g, double b, double a);
-    void queue_pixel_task(int x, int y, double r, double g, double b, double a);
-
-    // АЛГОРИТМЫ
-    void algo_step_line(int x1, int y1, int x2, int y2, double r, double g, double b);
-    void algo_dda(int x1, int y1, int x2, int y2, double r, double g, double b);
-    void algo_bresenham_line(int x1, int y1, int x2, int y2, double r, double g, double b);
-    void algo_bresenham_circle(int cx, int cy, int radius, double r, double g, double b);
-    
-    // Бонусы
-    void algo_antialiased(int x1, int y1, int x2, int y2); // Ву
-    void algo_bezier_quadratic(int x1, int y1, int cx, int cy, int x2, int y2); // Безье
-    void algo_castle_pitteway(int x1, int y1, int x2, int y2); // Кастла-Питвея (NEW)
-
-    void push_circle_points(int cx, int cy, int x, int y, double r, double g, double b);
+    void resize_canvas();
+    void canvas_origin(int& ox, int& oy);
+    void center_view();
+    void zoom_at(double zoom, double sx, double sy);
+    const Cairo::RefPtr<Cairo::SurfacePattern>& tile_pattern(int tx, int ty);
+    void rebuild_grid_layer();
+    void mark_dirty(const raster::DrawCommand& cmd);
+    void flush_dirty();
+    void start_playback();
+    void stop_playback();
+    void show_playback_stats(bool finished);
+    void show_bench_results();
 
     // GUI элементы
     Gtk::Box m_vbox;
@@ -60,23 +74,71 @@ protected:
     Gtk::Entry m_w_entry, m_h_entry;
     
     Gtk::SpinButton m_scale_spin;
-    Gtk::SpinButton m_delay_spin;
+    Gtk::SpinButton m_rate_spin;
+    Gtk::ComboBoxText m_blend_combo;
+    Gtk::SpinButton m_stroke_width;
+    Gtk::ComboBoxText m_join_combo, m_cap_combo;
 
     // Чекбоксы
     Gtk::CheckButton m_chk_seq, m_chk_dda, m_chk_bres, m_chk_circle;
-    Gtk::CheckButton m_chk_aa, m_chk_bezier, m_chk_castle; // Бонусные
+    Gtk::CheckButton m_chk_aa, m_chk_bezier, m_chk_castle, m_chk_fill; // Бонусные
+    Gtk::CheckButton m_chk_stroke;
+
+    Gtk::Label m_anim_stats;
+
+    // Замеры: отмеченные алгоритмы без очереди анимации, в пустой приемник и в буфер кадра
+    Gtk::Expander m_bench_expander;
+    Gtk::Grid m_bench_grid;
+    Gtk::SpinButton m_bench_reps, m_bench_warmup, m_bench_count;
+    Gtk::Entry m_bench_lengths, m_bench_angles;
+    Gtk::Button m_btn_bench, m_btn_bench_csv;
+    Gtk::ScrolledWindow m_bench_scroll;
+    Gtk::TextView m_bench_view;
+    std::vector<raster::BenchResult> m_bench_results;
 
-    Gtk::Button m_btn_draw, m_btn_clear, m_btn_real, m_btn_resize;
+    Gtk::Button m_btn_draw, m_btn_clear, m_btn_real, m_btn_resize, m_btn_fit;
 
     // Состояние
     int m_canvas_width = 50;
     int m_canvas_height = 50;
-    int m_pixel_scale = 9;
     bool m_is_real_line_active = false;
 
-    std::vector<unsigned char> m_pixel_data;
-    std::deque<PixelTask> m_tasks;
-    sigc::connection m_timeout_conn;
+    // Вид: экранных пикселей на пиксель холста и положение угла холста в области рисования
+    double m_zoom = 9;
+    double m_pan_x = 0, m_pan_y = 0;
+    bool m_center_pending = true;
+    bool m_zoom_syncing = false;
+    bool m_dragging = false;
+    double m_drag_x = 0, m_drag_y = 0;
+
+    raster::TiledFramebuffer m_canvas;
+    // Примитивы рисуются по запросу анимации: генераторы выдают порции в m_tasks,
+    // поэтому в очереди лежат только команды текущих порций
+    raster::GeneratorQueue m_generators;
+    raster::CommandBuffer m_tasks;
+
+    // Поверхности Cairo поверх памяти плиток m_canvas (создаются при первом показе плитки).
+    // Ключ - адрес памяти плитки, а не ее номер: clear() сохраняет память плиток и раздает
+    // ее заново, поэтому поверхности переживают очистку; resize() память освобождает -
+    // тогда поверхности удаляются
+    struct TileView
+    {
+        Cairo::RefPtr<Cairo::ImageSurface> surface;
+        Cairo::RefPtr<Cairo::SurfacePattern> pattern;
+    };
+    std::unordered_map<const uint8_t*, TileView> m_tile_views;
+
+    // Видимые линии сетки и подписи, отрисованные заранее; пересобираются при смене
+    // масштаба, сдвига, размера холста или области рисования
+    Cairo::RefPtr<Cairo::ImageSurface> m_grid_layer;
+    double m_grid_key[7] = {0, 0, 0, 0, 0, 0, 0};
+
+    // Пиксели, измененные с прошлого кадра
+    raster::ClipRect m_dirty = {0, 0, -1, -1};
+
+    // Анимация идет по часам кадров области рисования: пиксели за кадр - по целевой скорости
+    raster::PlaybackScheduler m_scheduler;
+    guint m_tick_id = 0;
 };
 
 RasterApp::RasterApp() : m_vbox(Gtk::ORIENTATION_VERTICAL, 6) {
@@ -86,6 +148,12 @@ RasterApp::RasterApp() : m_vbox(Gtk::ORIENTATION_VERTICAL, 6) {
 
     m_drawing_area.set_size_request(600, 500);
     m_drawing_area.signal_draw().connect(sigc::mem_fun(*this, &RasterApp::on_drawing_area_draw));
+    // Колесо - масштаб вокруг курсора, перетаскивание левой кнопкой - сдвиг
+    m_drawing_area.add_events(Gdk::SCROLL_MASK | Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK | Gdk::BUTTON1_MOTION_MASK);
+    m_drawing_area.signal_scroll_event().connect(sigc::mem_fun(*this, &RasterApp::on_area_scroll));
+    m_drawing_area.signal_button_press_event().connect(sigc::mem_fun(*this, &RasterApp::on_area_button_press));
+    m_drawing_area.signal_button_release_event().connect(sigc::mem_fun(*this, &RasterApp::on_area_button_release));
+    m_drawing_area.signal_motion_notify_event().connect(sigc::mem_fun(*this, &RasterApp::on_area_motion));
     m_vbox.pack_start(m_drawing_area, true, true, 0);
 
     m_grid.set_column_spacing(10);
@@ -131,13 +199,42 @@ RasterApp::RasterApp() : m_vbox(Gtk::ORIENTATION_VERTICAL, 6) {
 
     // Controls
     m_grid.attach(*Gtk::manage(new Gtk::Label("Scale:")), 0, row, 1, 1);
-    m_scale_spin.set_range(2, 100); m_scale_spin.set_increments(1, 5); m_scale_spin.set_value(m_pixel_scale);
+    m_scale_spin.set_digits(2); m_scale_spin.set_range(0.02, 100); m_scale_spin.set_increments(1, 5); m_scale_spin.set_value(m_zoom);
     m_scale_spin.signal_value_changed().connect(sigc::mem_fun(*this, &RasterApp::on_scale_changed));
     m_grid.attach(m_scale_spin, 1, row, 1, 1);
 
-    m_grid.attach(*Gtk::manage(new Gtk::Label("Delay(s):")), 2, row, 1, 1);
-    m_delay_spin.set_digits(3); m_delay_spin.set_range(0.000, 0.5); m_delay_spin.set_increments(0.001, 0.01); m_delay_spin.set_value(0.005);
-    m_grid.attach(m_delay_spin, 3, row, 1, 1);
+    m_grid.attach(*Gtk::manage(new Gtk::Label("Пикс/с:")), 2, row, 1, 1);
+    m_rate_spin.set_digits(0); m_rate_spin.set_range(1, 1e9); m_rate_spin.set_increments(100, 10000); m_rate_spin.set_value(500);
+    m_grid.attach(m_rate_spin, 3, row, 1, 1);
+
+    m_btn_fit.set_label("Вписать");
+    m_btn_fit.signal_clicked().connect(sigc::mem_fun(*this, &RasterApp::on_fit_clicked));
+    m_grid.attach(m_btn_fit, 4, row, 1, 1);
+    row++;
+
+    m_grid.attach(*Gtk::manage(new Gtk::Label("Смешивание:")), 0, row, 1, 1);
+    m_blend_combo.append("Поверх (Source Over)");
+    m_blend_combo.append("Замена (Replace)");
+    m_blend_combo.append("Сложение (Additive)");
+    m_blend_combo.append("Умножение (Multiply)");
+    m_blend_combo.set_active(0);
+    m_grid.attach(m_blend_combo, 1, row, 3, 1);
+    row++;
+
+    // Обводка ломаной P1 -> центр -> P2: ширина, стык, конец
+    m_grid.attach(*Gtk::manage(new Gtk::Label("Обводка:")), 0, row, 1, 1);
+    m_stroke_width.set_digits(1); m_stroke_width.set_range(0.5, 500); m_stroke_width.set_increments(1, 10); m_stroke_width.set_value(5);
+    m_grid.attach(m_stroke_width, 1, row, 1, 1);
+    m_join_combo.append("Острый стык");
+    m_join_combo.append("Круглый стык");
+    m_join_combo.append("Срезанный стык");
+    m_join_combo.set_active(0);
+    m_grid.attach(m_join_combo, 2, row, 1, 1);
+    m_cap_combo.append("Без конца");
+    m_cap_combo.append("Круглый конец");
+    m_cap_combo.append("Квадратный конец");
+    m_cap_combo.set_active(0);
+    m_grid.attach(m_cap_combo, 3, row, 1, 1);
 
     // Checkboxes
     int col = 5;
@@ -151,10 +248,12 @@ RasterApp::RasterApp() : m_vbox(Gtk::ORIENTATION_VERTICAL, 6) {
     m_chk_aa.set_label("Сглаживание By (Black)"); m_grid.attach(m_chk_aa, col, r_algo++, 2, 1);
     m_chk_bezier.set_label("Безье (Orange)"); m_grid.attach(m_chk_bezier, col, r_algo++, 2, 1);
     m_chk_castle.set_label("Кастла-Питвея (Cyan)"); m_grid.attach(m_chk_castle, col, r_algo++, 2, 1);
+    m_chk_fill.set_label("Заливка (Teal)"); m_grid.attach(m_chk_fill, col, r_algo++, 2, 1);
+    m_chk_stroke.set_label("Обводка (Brown)"); m_grid.attach(m_chk_stroke, col, r_algo++, 2, 1);
 
     row = std::max(row + 1, r_algo + 1);
     
-    m_btn_draw.set_label("Нарисовать + Замер времени");
+    m_btn_draw.set_label("Нарисовать");
     m_btn_draw.signal_clicked().connect(sigc::mem_fun(*this, &RasterApp::on_draw_clicked));
     m_grid.attach(m_btn_draw, 0, row, 3, 1);
 
@@ -165,20 +264,200 @@ RasterApp::RasterApp() : m_vbox(Gtk::ORIENTATION_VERTICAL, 6) {
     m_btn_real.set_label("Векторная линия");
     m_btn_real.signal_clicked().connect(sigc::mem_fun(*this, &RasterApp::on_draw_real_clicked));
     m_grid.attach(m_btn_real, 5, row, 2, 1);
+    row++;
 
-    clear_canvas_data();
+    m_anim_stats.set_xalign(0);
+    m_grid.attach(m_anim_stats, 0, row, 7, 1);
+
+    // Замеры
+    m_bench_expander.set_label("Замеры");
+    m_bench_grid.set_column_spacing(10);
+    m_bench_grid.set_row_spacing(5);
+    m_bench_grid.set_border_width(10);
+    m_bench_expander.add(m_bench_grid);
+    m_vbox.pack_start(m_bench_expander, false, false, 0);
+
+    m_bench_grid.attach(*Gtk::manage(new Gtk::Label("Повторов:")), 0, 0, 1, 1);
+    m_bench_reps.set_digits(0); m_bench_reps.set_range(1, 100000); m_bench_reps.set_increments(10, 100); m_bench_reps.set_value(30);
+    m_bench_grid.attach(m_bench_reps, 1, 0, 1, 1);
+    m_bench_grid.attach(*Gtk::manage(new Gtk::Label("Прогрев:")), 2, 0, 1, 1);
+    m_bench_warmup.set_digits(0); m_bench_warmup.set_range(0, 1000); m_bench_warmup.set_increments(1, 10); m_bench_warmup.set_value(3);
+    m_bench_grid.attach(m_bench_warmup, 3, 0, 1, 1);
+    m_bench_grid.attach(*Gtk::manage(new Gtk::Label("Отрезков:")), 4, 0, 1, 1);
+    m_bench_count.set_digits(0); m_bench_count.set_range(1, 1000000); m_bench_count.set_increments(100, 1000); m_bench_count.set_value(500);
+    m_bench_grid.attach(m_bench_count, 5, 0, 1, 1);
+
+    m_bench_grid.attach(*Gtk::manage(new Gtk::Label("Длины:")), 0, 1, 1, 1);
+    m_bench_lengths.set_text("16,128,1024"); m_bench_grid.attach(m_bench_lengths, 1, 1, 1, 1);
+    m_bench_grid.attach(*Gtk::manage(new Gtk::Label("Наклоны (°):")), 2, 1, 1, 1);
+    m_bench_angles.set_tooltip_text("Через запятую; пусто - случайный наклон");
+    m_bench_grid.attach(m_bench_angles, 3, 1, 1, 1);
+    m_btn_bench.set_label("Замерить");
+    m_btn_bench.signal_clicked().connect(sigc::mem_fun(*this, &RasterApp::on_bench_clicked));
+    m_bench_grid.attach(m_btn_bench, 4, 1, 1, 1);
+    m_btn_bench_csv.set_label("CSV...");
+    m_btn_bench_csv.signal_clicked().connect(sigc::mem_fun(*this, &RasterApp::on_bench_csv_clicked));
+    m_bench_grid.attach(m_btn_bench_csv, 5, 1, 1, 1);
+
+    m_bench_view.set_editable(false);
+    m_bench_view.set_monospace(true);
+    m_bench_scroll.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+    m_bench_scroll.set_min_content_height(160);
+    m_bench_scroll.add(m_bench_view);
+    m_bench_grid.attach(m_bench_scroll, 0, 2, 6, 1);
+
+    resize_canvas();
     show_all_children();
 }
 
-RasterApp::~RasterApp() { if (m_timeout_conn) m_timeout_conn.disconnect(); }
+RasterApp::~RasterApp() { stop_playback(); }
 
+// Очистка сохраняет память плиток и их поверхности: повторное "Нарисовать" ничего не выделяет
 void RasterApp::clear_canvas_data() {
-    size_t size = m_canvas_width * m_canvas_height * 4;
-    m_pixel_data.assign(size, 255);
+    m_canvas.clear();
+    m_dirty = {0, 0, -1, -1};
+}
+
+void RasterApp::resize_canvas() {
+    if (m_canvas.width() == m_canvas_width && m_canvas.height() == m_canvas_height) return;
+    m_canvas.resize(m_canvas_width, m_canvas_height);
+    m_tile_views.clear();
+}
+
+const Cairo::RefPtr<Cairo::SurfacePattern>& RasterApp::tile_pattern(int tx, int ty) {
+    TileView& v = m_tile_views[m_canvas.tile(tx, ty)];
+    if (!v.pattern) {
+        const int T = raster::TiledFramebuffer::TILE;
+        v.surface = Cairo::ImageSurface::create(m_canvas.tile(tx, ty), Cairo::FORMAT_ARGB32, T, T, m_canvas.tile_stride());
+        v.pattern = Cairo::SurfacePattern::create(v.surface);
+        v.pattern->set_filter(Cairo::FILTER_NEAREST);
+    }
+    return v.pattern;
+}
+
+// Левый верхний угол холста в области рисования (целые пиксели, чтобы слой сетки не размывался)
+void RasterApp::canvas_origin(int& ox, int& oy) {
+    ox = (int)std::floor(m_pan_x);
+    oy = (int)std::floor(m_pan_y);
+}
+
+void RasterApp::center_view() {
+    Gtk::Allocation allocation = m_drawing_area.get_allocation();
+    m_pan_x = (allocation.get_width() - m_canvas_width * m_zoom) / 2;
+    m_pan_y = (allocation.get_height() - m_canvas_height * m_zoom) / 2;
+}
+
+// Новый масштаб; точка холста под (sx, sy) остается на месте
+void RasterApp::zoom_at(double zoom, double sx, double sy) {
+    zoom = std::clamp(zoom, 0.02, 100.0);
+    m_pan_x = sx - (sx - m_pan_x) / m_zoom * zoom;
+    m_pan_y = sy - (sy - m_pan_y) / m_zoom * zoom;
+    m_zoom = zoom;
+
+    m_zoom_syncing = true;
+    m_scale_spin.set_value(m_zoom);
+    m_zoom_syncing = false;
+    m_drawing_area.queue_draw();
+}
+
+// Слой размером с область рисования: видимые линии сетки и подписи
+void RasterApp::rebuild_grid_layer() {
+    Gtk::Allocation allocation = m_drawing_area.get_allocation();
+    int w = allocation.get_width();
+    int h = allocation.get_height();
+    double z = m_zoom;
+    int ox, oy;
+    canvas_origin(ox, oy);
+
+    double key[7] = {z, (double)m_canvas_width, (double)m_canvas_height, (double)w, (double)h, (double)ox, (double)oy};
+    std::copy(key, key + 7, m_grid_key);
+    m_grid_layer = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, std::max(w, 1), std::max(h, 1));
+
+    // Только линии и подписи, попадающие в область
+    int i0 = std::clamp((int)std::ceil(-ox / z), 0, m_canvas_width);
+    int i1 = std::clamp((int)std::floor((w - ox) / z), 0, m_canvas_width);
+    int j0 = std::clamp((int)std::ceil(-oy / z), 0, m_canvas_height);
+    int j1 = std::clamp((int)std::floor((h - oy) / z), 0, m_canvas_height);
+    // Видимая часть холста в экранных пикселях относительно его угла
+    double vx0 = std::max(0.0, -(double)ox), vx1 = std::min(m_canvas_width * z, (double)(w - ox));
+    double vy0 = std::max(0.0, -(double)oy), vy1 = std::min(m_canvas_height * z, (double)(h - oy));
+
+    auto cr = Cairo::Context::create(m_grid_layer);
+    cr->translate(ox, oy);
+    if (z >= 2) { // при меньшем масштабе линии закрыли бы рисунок
+        cr->set_source_rgb(0.8, 0.8, 0.8);
+        cr->set_line_width(1.0);
+        for(int i=i0; i<=i1; ++i) { cr->move_to(i*z, vy0); cr->line_to(i*z, vy1); }
+        for(int i=j0; i<=j1; ++i) { cr->move_to(vx0, i*z); cr->line_to(vx1, i*z); }
+        cr->stroke();
+    }
+
+    // Шаг подписей 5, 10, 20, ...: не ближе 30 экранных пикселей;
+    // если край холста ушел за область, подписи прижимаются к ее краю
+    double font = std::clamp(z*0.7, 10.0, 70.0);
+    int step = 5;
+    while (step * z < 30) step *= 2;
+    double top = std::max(0.0, font + 5 - oy);
+    double left = std::max(0.0, font * 4 - ox);
+
+    cr->set_source_rgb(0,0,0);
+    cr->set_font_size(font);
+    Cairo::TextExtents te;
+    for(int i=(i0 + step - 1) / step * step; i<=i1; i+=step) {
+        std::string t = std::to_string(i);
+        cr->get_text_extents(t, te);
+        cr->move_to(i*z - te.width/2, top - 5);
+        cr->show_text(t);
+    }
+    for(int i=(j0 + step - 1) / step * step; i<=j1; i+=step) {
+        std::string t = std::to_string(i);
+        cr->get_text_extents(t, te);
+        cr->move_to(left - te.width-5, i*z + te.height/2);
+        cr->show_text(t);
+    }
+}
+
+void RasterApp::mark_dirty(const raster::DrawCommand& cmd) {
+    int x1 = cmd.x, y1 = cmd.y;
+    if (cmd.kind() == raster::SPAN_HORIZONTAL) x1 += cmd.length() - 1; else y1 += cmd.length() - 1;
+    if (m_dirty.empty()) { m_dirty = {cmd.x, cmd.y, x1, y1}; return; }
+    m_dirty.x0 = std::min(m_dirty.x0, (int)cmd.x); m_dirty.y0 = std::min(m_dirty.y0, (int)cmd.y);
+    m_dirty.x1 = std::max(m_dirty.x1, x1); m_dirty.y1 = std::max(m_dirty.y1, y1);
+}
+
+// Сообщает Cairo об измененных плитках и перерисовывает только экранный прямоугольник изменений
+void RasterApp::flush_dirty() {
+    raster::ClipRect d = m_dirty;
+    m_dirty = {0, 0, -1, -1};
+    d.x0 = std::max(d.x0, 0); d.y0 = std::max(d.y0, 0);
+    d.x1 = std::min(d.x1, m_canvas.width() - 1); d.y1 = std::min(d.y1, m_canvas.height() - 1);
+    if (d.empty()) return;
+
+    const int T = raster::TiledFramebuffer::TILE;
+    for (int ty = d.y0 / T; ty <= d.y1 / T; ++ty) {
+        for (int tx = d.x0 / T; tx <= d.x1 / T; ++tx) {
+            const uint8_t* data = m_canvas.tile(tx, ty);
+            if (!data) continue;
+            auto it = m_tile_views.find(data);
+            if (it != m_tile_views.end()) it->second.surface->mark_dirty();
+        }
+    }
+
+    // Линии сетки на границах квадратов заходят на соседние экранные пиксели
+    Gtk::Allocation allocation = m_drawing_area.get_allocation();
+    int ox, oy;
+    canvas_origin(ox, oy);
+    double sx0 = std::max(0.0, std::floor(ox + d.x0 * m_zoom) - 1);
+    double sy0 = std::max(0.0, std::floor(oy + d.y0 * m_zoom) - 1);
+    double sx1 = std::min((double)allocation.get_width(), std::ceil(ox + (d.x1 + 1) * m_zoom) + 1);
+    double sy1 = std::min((double)allocation.get_height(), std::ceil(oy + (d.y1 + 1) * m_zoom) + 1);
+    if (sx0 < sx1 && sy0 < sy1)
+        m_drawing_area.queue_draw_area((int)sx0, (int)sy0, (int)(sx1 - sx0), (int)(sy1 - sy0));
 }
 
 void RasterApp::on_clear_clicked() {
-    if (m_timeout_conn) m_timeout_conn.disconnect();
+    stop_playback();
+    m_generators.clear();
     m_tasks.clear();
     clear_canvas_data();
     m_drawing_area.queue_draw();
@@ -186,404 +465,337 @@ void RasterApp::on_clear_clicked() {
 
 void RasterApp::on_resize_clicked() {
     try {
-        m_canvas_width = std::stoi(m_w_entry.get_text());
-        m_canvas_height = std::stoi(m_h_entry.get_text());
+        // Координаты команд 16-битные: холст до 32768 x 32768
+        m_canvas_width = std::clamp(std::stoi(m_w_entry.get_text()), 1, 32768);
+        m_canvas_height = std::clamp(std::stoi(m_h_entry.get_text()), 1, 32768);
+        m_center_pending = true;
         on_clear_clicked();
+        resize_canvas();
     } catch (...) {}
 }
 
 void RasterApp::on_scale_changed() {
-    m_pixel_scale = (int)m_scale_spin.get_value();
-    m_drawing_area.queue_draw();
+    if (m_zoom_syncing) return;
+    Gtk::Allocation allocation = m_drawing_area.get_allocation();
+    zoom_at(m_scale_spin.get_value(), allocation.get_width() / 2.0, allocation.get_height() / 2.0);
 }
 
-void RasterApp::on_draw_real_clicked() {
-    m_is_real_line_active = !m_is_real_line_active;
-    m_drawing_area.queue_draw();
+void RasterApp::on_fit_clicked() {
+    Gtk::Allocation allocation = m_drawing_area.get_allocation();
+    double z = std::min((allocation.get_width() - 60.0) / m_canvas_width, (allocation.get_height() - 40.0) / m_canvas_height);
+    zoom_at(z, 0, 0);
+    center_view();
 }
 
-void RasterApp::set_pixel_instant(int x, int y, double r_new, double g_new, double b_new, double alpha_val) {
-    if (x < 0 || x >= m_canvas_width || y < 0 || y >= m_canvas_height) return;
-    int index = (y * m_canvas_width + x) * 4;
-    unsigned char b_curr = m_pixel_data[index + 0];
-    unsigned char g_curr = m_pixel_data[index + 1];
-    unsigned char r_curr = m_pixel_data[index + 2];
-    unsigned char a_curr = m_pixel_data[index + 3];
-
-    double a_norm = std::clamp(alpha_val, 0.0, 1.0);
-    bool is_white = (a_curr == 255 && b_curr == 255 && g_curr == 255 && r_curr == 255);
-    unsigned char r_out, g_out, b_out, a_out;
-
-    if (is_white) {
-        b_out = (unsigned char)(b_new * 255 * a_norm + b_curr * (1.0 - a_norm));
-        g_out = (unsigned char)(g_new * 255 * a_norm + g_curr * (1.0 - a_norm));
-        r_out = (unsigned char)(r_new * 255 * a_norm + r_curr * (1.0 - a_norm));
-        a_out = 255;
-    } else {
-        b_out = std::min(255, (int)(b_curr + b_new * 255 * 0.5)); // Simple blend
-        g_out = std::min(255, (int)(g_curr + g_new * 255 * 0.5));
-        r_out = std::min(255, (int)(r_curr + r_new * 255 * 0.5));
-        a_out = 255;
-    }
-    m_pixel_data[index] = b_out; m_pixel_data[index+1] = g_out;
-    m_pixel_data[index+2] = r_out; m_pixel_data[index+3] = a_out;
+bool RasterApp::on_area_scroll(GdkEventScroll* event) {
+    if (event->direction == GDK_SCROLL_UP) zoom_at(m_zoom * 1.25, event->x, event->y);
+    else if (event->direction == GDK_SCROLL_DOWN) zoom_at(m_zoom / 1.25, event->x, event->y);
+    return true;
 }
 
-void RasterApp::queue_pixel_task(int x, int y, double r, double g, double b, double a) {
-    m_tasks.push_back({x, y, r, g, b, a});
+bool RasterApp::on_area_button_press(GdkEventButton* event) {
+    if (event->button != 1) return false;
+    m_dragging = true;
+    m_drag_x = event->x;
+    m_drag_y = event->y;
+    return true;
 }
 
-bool RasterApp::on_timeout_step() {
-    if (m_tasks.empty()) { m_timeout_conn.disconnect(); return false; }
-    
-    int batch = (m_delay_spin.get_value() < 0.002) ? 20 : 1;
-    
-    for(int i=0; i<batch && !m_tasks.empty(); ++i) {
-        PixelTask t = m_tasks.front();
-        m_tasks.pop_front();
-        set_pixel_instant(t.x, t.y, t.r, t.g, t.b, t.alpha);
-    }
+bool RasterApp::on_area_button_release(GdkEventButton* event) {
+    if (event->button == 1) m_dragging = false;
+    return true;
+}
+
+bool RasterApp::on_area_motion(GdkEventMotion* event) {
+    if (!m_dragging) return false;
+    m_pan_x += event->x - m_drag_x;
+    m_pan_y += event->y - m_drag_y;
+    m_drag_x = event->x;
+    m_drag_y = event->y;
     m_drawing_area.queue_draw();
     return true;
 }
 
-void RasterApp::on_draw_clicked() {
-    on_clear_clicked();
+void RasterApp::on_bench_clicked() {
+    // Флажки окна -> имена алгоритмов raster::bench_algorithms()
+    std::vector<std::string> names;
+    if (m_chk_seq.get_active()) names.push_back("step");
+    if (m_chk_dda.get_active()) names.push_back("dda");
+    if (m_chk_bres.get_active()) names.push_back("bresenham");
+    if (m_chk_circle.get_active()) names.push_back("circle");
+    if (m_chk_aa.get_active()) names.push_back("wu");
+    if (m_chk_bezier.get_active()) names.push_back("bezier");
+    if (m_chk_castle.get_active()) names.push_back("castle");
+    if (m_chk_fill.get_active()) { names.push_back("fill_circle"); names.push_back("fill_polygon"); }
+    if (m_chk_stroke.get_active()) { names.push_back("stroke"); names.push_back("stroke_wide"); }
+    if (names.empty()) { m_bench_view.get_buffer()->set_text("Отметьте алгоритмы для замера."); return; }
+
+    std::vector<double> lengths;
+    std::vector<std::optional<double>> angles;
     try {
-        int x1 = std::stoi(m_x1.get_text()), y1 = std::stoi(m_y1.get_text());
-        int x2 = std::stoi(m_x2.get_text()), y2 = std::stoi(m_y2.get_text());
-        int cx = std::stoi(m_cx.get_text()), cy = std::stoi(m_cy.get_text());
-        int r  = std::stoi(m_radius.get_text());
-
-        std::cout << "--- Результаты замеров (мкс) ---" << std::endl;
-
-        if (m_chk_seq.get_active()) {
-            auto start = std::chrono::high_resolution_clock::now();
-            algo_step_line(x1, y1, x2, y2, 1.0, 0, 0);
-            auto end = std::chrono::high_resolution_clock::now();
-            std::cout << "Step-by-Step: " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << " us" << std::endl;
-        }
-        if (m_chk_dda.get_active()) {
-            auto start = std::chrono::high_resolution_clock::now();
-            algo_dda(x1, y1, x2, y2, 0, 0.8, 0);
-            auto end = std::chrono::high_resolution_clock::now();
-            std::cout << "DDA: " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << " us" << std::endl;
-        }
-        if (m_chk_bres.get_active()) {
-            auto start = std::chrono::high_resolution_clock::now();
-            algo_bresenham_line(x1, y1, x2, y2, 0, 0, 1.0);
-            auto end = std::chrono::high_resolution_clock::now();
-            std::cout << "Bresenham Line: " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << " us" << std::endl;
-        }
-        if (m_chk_circle.get_active()) {
-            auto start = std::chrono::high_resolution_clock::now();
-            algo_bresenham_circle(cx, cy, r, 0.6, 0, 0.6);
-            auto end = std::chrono::high_resolution_clock::now();
-            std::cout << "Bresenham Circle: " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << " us" << std::endl;
-        }
-        if (m_chk_aa.get_active()) {
-            auto start = std::chrono::high_resolution_clock::now();
-            algo_antialiased(x1, y1, x2, y2);
-            auto end = std::chrono::high_resolution_clock::now();
-            std::cout << "Wu (Antialiased): " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << " us" << std::endl;
-        }
-        if (m_chk_bezier.get_active()) {
-            auto start = std::chrono::high_resolution_clock::now();
-            algo_bezier_quadratic(x1, y1, cx, cy, x2, y2);
-            auto end = std::chrono::high_resolution_clock::now();
-            std::cout << "Bezier Quadratic: " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << " us" << std::endl;
-        }
-        if (m_chk_castle.get_active()) {
-            auto start = std::chrono::high_resolution_clock::now();
-            algo_castle_pitteway(x1, y1, x2, y2);
-            auto end = std::chrono::high_resolution_clock::now();
-            std::cout << "Castle-Pitteway: " << std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() << " us" << std::endl;
-        }
-
-        if (!m_tasks.empty()) {
-            int delay_ms = std::max(1, (int)(m_delay_spin.get_value() * 1000));
-            m_timeout_conn = Glib::signal_timeout().connect(sigc::mem_fun(*this, &RasterApp::on_timeout_step), delay_ms);
-        }
-
-    } catch (...) { std::cerr << "Input Error" << std::endl; }
-}
+        lengths = parse_numbers(m_bench_lengths.get_text());
+        for (double a : parse_numbers(m_bench_angles.get_text())) angles.push_back(a);
+    } catch (...) { m_bench_view.get_buffer()->set_text("Длины и наклоны - числа через запятую."); return; }
+    if (lengths.empty()) lengths.push_back(128);
+    // Пустое поле - случайный наклон; отрицательные углы (-45) - обычный наклон
+    if (angles.empty()) angles.push_back(std::nullopt);
+
+    static const raster::BlendMode modes[] = {
+        raster::BlendMode::SourceOver, raster::BlendMode::Replace,
+        raster::BlendMode::Additive, raster::BlendMode::Multiply
+    };
 
-// Реализация алгоритмов
-void RasterApp::algo_step_line(int x1, int y1, int x2, int y2, double r, double g, double b) {
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-    if (dx == 0 && dy == 0) { queue_pixel_task(x1, y1, r, g, b, 1.0); return; }
-    
-    if (abs(dx) >= abs(dy)) {
-        if (x1 > x2) { std::swap(x1, x2); std::swap(y1, y2); }
-        double k = (double)(y2 - y1) / (x2 - x1);
-        double y = y1;
-        for (int x = x1; x <= x2; x++) {
-            queue_pixel_task(x, round(y), r, g, b, 1.0);
-            y += k;
-        }
-    } else {
-        if (y1 > y2) { std::swap(x1, x2); std::swap(y1, y2); }
-        double k = (double)(x2 - x1) / (y2 - y1);
-        double x = x1;
-        for (int y = y1; y <= y2; y++) {
-            queue_pixel_task(round(x), y, r, g, b, 1.0);
-            x += k;
+    // Отдельный буфер кадра того же размера, что у raster_bench по умолчанию: холст окна
+    // бывает 50x50, и длинные отрезки обрезались бы
+    const int W = 2048, H = 2048;
+    raster::Framebuffer fb(W, H);
+    raster::FramebufferSink fb_sink(fb);
+    fb_sink.set_color(0, 0, 1.0);
+    fb_sink.set_blend_mode(modes[std::max(0, m_blend_combo.get_active_row_number())]);
+    raster::CountingSink null_sink;
+    auto clear_fb = [](void* ctx) { static_cast<raster::Framebuffer*>(ctx)->clear(); };
+
+    int reps = m_bench_reps.get_value_as_int(), warmup = m_bench_warmup.get_value_as_int();
+    size_t count = (size_t)m_bench_count.get_value_as_int();
+    m_bench_results.clear();
+    for (double length : lengths) for (const std::optional<double>& angle : angles) {
+        int len = std::clamp((int)std::lround(length), 1, W - 1);
+        std::vector<raster::Segment> segments = angle
+            ? raster::sloped_segments(count, len, *angle, W, H, 42)
+            : raster::random_segments(count, len, W, H, 42);
+        for (const raster::BenchAlgorithm& algo : raster::bench_algorithms()) {
+            if (std::find(names.begin(), names.end(), algo.name) == names.end()) continue;
+            raster::BenchResult r = raster::run_benchmark(algo, segments, null_sink, "null", warmup, reps);
+            r.length = len; r.angle = angle;
+            m_bench_results.push_back(r);
+            r = raster::run_benchmark(algo, segments, fb_sink, "framebuffer", warmup, reps, clear_fb, &fb);
+            r.length = len; r.angle = angle;
+            m_bench_results.push_back(r);
         }
     }
+    show_bench_results();
 }
 
-void RasterApp::algo_dda(int x1, int y1, int x2, int y2, double r, double g, double b) {
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-    int steps = std::max(std::abs(dx), std::abs(dy));
-    if (steps == 0) { queue_pixel_task(x1, y1, r, g, b, 1.0); return; }
-
-    double x_inc = (double)dx / steps;
-    double y_inc = (double)dy / steps;
-    double x = x1;
-    double y = y1;
-
-    for (int i = 0; i <= steps; ++i) {
-        queue_pixel_task((int)std::round(x), (int)std::round(y), r, g, b, 1.0);
-        x += x_inc;
-        y += y_inc;
+void RasterApp::show_bench_results() {
+    std::ostringstream os;
+    os << std::left << std::setw(14) << "algorithm" << std::setw(13) << "sink" << std::right
+       << std::setw(7) << "length" << std::setw(7) << "angle" << std::setw(10) << "pixels"
+       << std::setw(13) << "min_ns" << std::setw(13) << "median_ns" << std::setw(13) << "p99_ns"
+       << std::setw(9) << "ns/px" << std::setw(14) << "pixels/s" << "\n";
+    for (const raster::BenchResult& r : m_bench_results) {
+        os << std::left << std::setw(14) << r.algorithm << std::setw(13) << r.sink << std::right
+           << std::setw(7) << r.length << std::setw(7) << (r.angle ? std::to_string((int)std::lround(*r.angle)) : std::string("rand"))
+           << std::setw(10) << r.pixels << std::fixed << std::setprecision(0)
+           << std::setw(13) << r.stats.min_ns << std::setw(13) << r.stats.median_ns << std::setw(13) << r.stats.p99_ns
+           << std::setprecision(2) << std::setw(9) << r.ns_per_pixel()
+           << std::setprecision(0) << std::setw(14) << r.pixels_per_sec() << "\n";
+        os.unsetf(std::ios::floatfield);
     }
+    os << "Время - на весь набор из " << m_bench_count.get_value_as_int() << " отрезков, " << m_bench_reps.get_value_as_int()
+       << " повторов после " << m_bench_warmup.get_value_as_int() << " прогревочных.";
+    m_bench_view.get_buffer()->set_text(os.str());
 }
 
-void RasterApp::algo_bresenham_line(int x1, int y1, int x2, int y2, double r, double g, double b) {
-    int dx = std::abs(x2 - x1);
-    int dy = std::abs(y2 - y1);
-    int sx = (x1 < x2) ? 1 : -1;
-    int sy = (y1 < y2) ? 1 : -1;
-    int err = dx - dy;
-
-    int x = x1;
-    int y = y1;
-
-    while (true) {
-        queue_pixel_task(x, y, r, g, b, 1.0);
-        if (x == x2 && y == y2) break;
-        int e2 = 2 * err;
-        if (e2 > -dy) { err -= dy; x += sx; }
-        if (e2 < dx) { err += dx; y += sy; }
-    }
+void RasterApp::on_bench_csv_clicked() {
+    if (m_bench_results.empty()) return;
+    Gtk::FileChooserDialog dialog(*this, "Сохранить замеры", Gtk::FILE_CHOOSER_ACTION_SAVE);
+    dialog.add_button("Отмена", Gtk::RESPONSE_CANCEL);
+    dialog.add_button("Сохранить", Gtk::RESPONSE_ACCEPT);
+    dialog.set_do_overwrite_confirmation(true);
+    dialog.set_current_name("raster_bench.csv");
+    if (dialog.run() != Gtk::RESPONSE_ACCEPT) return;
+
+    // Тот же формат, что у raster_bench --format csv
+    std::ofstream out(dialog.get_filename());
+    out << raster::csv_header() << "\n";
+    for (const raster::BenchResult& r : m_bench_results) out << raster::to_csv(r) << "\n";
+    if (!out) std::cerr << "Cannot write " << dialog.get_filename() << std::endl;
 }
 
-void RasterApp::push_circle_points(int cx, int cy, int x, int y, double r, double g, double b) {
-    int pts[8][2] = {
-        {cx+x, cy+y}, {cx-x, cy+y}, {cx+x, cy-y}, {cx-x, cy-y},
-        {cx+y, cy+x}, {cx-y, cy+x}, {cx+y, cy-x}, {cx-y, cy-x}
-    };
-    for(auto& p : pts) queue_pixel_task(p[0], p[1], r, g, b, 1.0);
+void RasterApp::on_draw_real_clicked() {
+    m_is_real_line_active = !m_is_real_line_active;
+    m_drawing_area.queue_draw();
 }
 
-void RasterApp::algo_bresenham_circle(int cx, int cy, int radius, double r, double g, double b) {
-    int x = 0;
-    int y = radius;
-    int d = 3 - 2 * radius;
-    push_circle_points(cx, cy, x, y, r, g, b);
-    while (x < y) {
-        if (d < 0) d = d + 4 * x + 6;
-        else { d = d + 4 * (x - y) + 10; y--; }
-        x++;
-        push_circle_points(cx, cy, x, y, r, g, b);
-    }
+void RasterApp::start_playback() {
+    m_scheduler.start();
+    if (!m_tick_id) m_tick_id = m_drawing_area.add_tick_callback(sigc::mem_fun(*this, &RasterApp::on_tick));
 }
 
-// Алгоритм Кастла-Питвея (Лингвистический/Евклидов)
-void RasterApp::algo_castle_pitteway(int x1, int y1, int x2, int y2) {
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-
-    int sx = (dx >= 0) ? 1 : -1;
-    int sy = (dy >= 0) ? 1 : -1;
-
-    int a = std::abs(dx);
-    int b = std::abs(dy);
-    
-    bool steep = b > a;
-    if (steep) std::swap(a, b);
+void RasterApp::stop_playback() {
+    if (m_tick_id) m_drawing_area.remove_tick_callback(m_tick_id);
+    m_tick_id = 0;
+}
 
-    std::string m1 = "s"; 
-    std::string m2 = "d";
+void RasterApp::show_playback_stats(bool finished) {
+    const raster::PlaybackStats& st = m_scheduler.stats();
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(0)
+         << "Кадров: " << st.frames << ", пропущено: " << st.dropped_frames
+         << ", не успели: " << st.late_frames << ", пикселей: " << st.pixels
+         << ", скорость: " << st.achieved_rate() << " пикс/с из " << m_scheduler.rate()
+         << ", макс. работа: " << st.max_work_us << " мкс";
+    m_anim_stats.set_text(text.str());
+    if (finished) std::cout << "Playback: " << text.str() << std::endl;
+}
 
-    int x_alg = a - b;
-    int y_alg = b;
-    
-    std::string pattern;
-    
-    if (y_alg == 0) {
-        pattern = "s"; 
-    } else if (x_alg == 0) {
-        pattern = "d";
-    } else {
-        while (x_alg != y_alg) {
-            if (x_alg > y_alg) {
-                x_alg = x_alg - y_alg;
-                m2 = m1 + m2;
-            } else {
-                y_alg = y_alg - x_alg;
-                m1 = m2 + m1;
-            }
-        }
-        pattern = m2 + m1;
+bool RasterApp::on_tick(const Glib::RefPtr<Gdk::FrameClock>& clock) {
+    if (m_tasks.empty() && m_generators.empty()) {
+        m_tick_id = 0;
+        show_playback_stats(true);
+        return false;
     }
 
-    int cur_x = x1;
-    int cur_y = y1;
-
-    queue_pixel_task(cur_x, cur_y, 0.0, 1.0, 1.0, 1.0);
-    
-    int repeats = (x_alg == 0) ? a : x_alg; // Если x_alg стал 0 (диагональ), то повторяем 'a' раз 'd'
-    if (y_alg == 0) repeats = a; // Для прямых
-    
-    std::string full_path = "";
-    for(int i=0; i < repeats; ++i) full_path += pattern;
-
-    // Проходим по сгенерированной строке
-    for (char move : full_path) {
-        if (steep) {
-            if (move == 's') {
-                cur_y += sy; 
-            } else {
-                cur_y += sy;
-                cur_x += sx;
-            }
-        } else {
-            if (move == 's') {
-                cur_x += sx;
-            } else {
-                cur_x += sx;
-                cur_y += sy;
-            }
+    static const raster::BlendMode modes[] = {
+        raster::BlendMode::SourceOver, raster::BlendMode::Replace,
+        raster::BlendMode::Additive, raster::BlendMode::Multiply
+    };
+    raster::BlendMode mode = modes[std::max(0, m_blend_combo.get_active_row_number())];
+
+    // Период обновления монитора; если часы его не знают - 60 Гц
+    gint64 now = clock->get_frame_time();
+    gint64 refresh = 0, presentation = 0;
+    clock->get_refresh_info(now, &refresh, &presentation);
+    if (refresh <= 0) refresh = 16667;
+
+    // Серии проигрываются целиком; скорость меняется на лету
+    m_scheduler.set_rate(m_rate_spin.get_value());
+    m_scheduler.run_frame(now, refresh, [&]() -> int {
+        if (m_tasks.empty()) {
+            // Сыгранные команды не хранятся: буфер очищается и заполняется следующими порциями
+            m_tasks.clear();
+            if (!m_generators.pull(m_tasks) && m_tasks.empty()) return 0;
         }
-        queue_pixel_task(cur_x, cur_y, 0.0, 1.0, 1.0, 1.0);
-    }
+        mark_dirty(m_tasks.front());
+        return m_tasks.play_front(m_canvas, mode);
+    });
+    flush_dirty();
+    if (clock->get_frame_counter() % 15 == 0) show_playback_stats(false);
+    return true;
 }
 
-// Сглаживание (Алгоритм Ву)
-void RasterApp::algo_antialiased(int x1, int y1, int x2, int y2) {
-    auto ipart = [](double x) { return (int)std::floor(x); };
-    auto round_ = [](double x) { return (int)std::round(x); };
-    auto fpart = [](double x) { return x - std::floor(x); };
-    auto rfpart = [&](double x) { return 1.0 - fpart(x); };
-
-    bool steep = std::abs(y2 - y1) > std::abs(x2 - x1);
-    if (steep) { std::swap(x1, y1); std::swap(x2, y2); }
-    if (x1 > x2) { std::swap(x1, x2); std::swap(y1, y2); }
-
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-    double gradient = (dx == 0) ? 1.0 : (double)dy / dx;
-
-    int xend = round_(x1);
-    double yend = y1 + gradient * (xend - x1);
-    double xgap = rfpart(x1 + 0.5);
-    int xpxl1 = xend;
-    int ypxl1 = ipart(yend);
-    
-    if (steep) {
-        queue_pixel_task(ypxl1, xpxl1, 0,0,0, rfpart(yend) * xgap);
-        queue_pixel_task(ypxl1+1, xpxl1, 0,0,0, fpart(yend) * xgap);
-    } else {
-        queue_pixel_task(xpxl1, ypxl1, 0,0,0, rfpart(yend) * xgap);
-        queue_pixel_task(xpxl1, ypxl1+1, 0,0,0, fpart(yend) * xgap);
-    }
-    double intery = yend + gradient;
-
-    xend = round_(x2);
-    yend = y2 + gradient * (xend - x2);
-    xgap = fpart(x2 + 0.5);
-    int xpxl2 = xend;
-    int ypxl2 = ipart(yend);
-    
-    for (int x = xpxl1 + 1; x < xpxl2; x++) {
-        if (steep) {
-            queue_pixel_task(ipart(intery), x, 0,0,0, rfpart(intery));
-            queue_pixel_task(ipart(intery)+1, x, 0,0,0, fpart(intery));
-        } else {
-            queue_pixel_task(x, ipart(intery), 0,0,0, rfpart(intery));
-            queue_pixel_task(x, ipart(intery)+1, 0,0,0, fpart(intery));
+void RasterApp::on_draw_clicked() {
+    on_clear_clicked();
+    try {
+        int x1 = std::stoi(m_x1.get_text()), y1 = std::stoi(m_y1.get_text());
+        int x2 = std::stoi(m_x2.get_text()), y2 = std::stoi(m_y2.get_text());
+        int cx = std::stoi(m_cx.get_text()), cy = std::stoi(m_cy.get_text());
+        int r  = std::stoi(m_radius.get_text());
+        // Все алгоритмы отсекаются по холсту до растеризации: невидимые части не обходятся
+        raster::ClipRect clip = {0, 0, m_canvas_width - 1, m_canvas_height - 1};
+
+        if (m_chk_seq.get_active())
+            m_generators.add(raster::make_line_generator(raster::step_line_clipped, x1, y1, x2, y2, clip), 1.0, 0, 0);
+        if (m_chk_dda.get_active())
+            m_generators.add(raster::make_line_generator(raster::dda_line_clipped, x1, y1, x2, y2, clip), 0, 0.8, 0);
+        if (m_chk_bres.get_active())
+            m_generators.add(raster::make_line_generator(raster::bresenham_line_clipped, x1, y1, x2, y2, clip), 0, 0, 1.0);
+        if (m_chk_circle.get_active())
+            m_generators.add(raster::make_circle_generator(cx, cy, r, clip), 0.6, 0, 0.6);
+        if (m_chk_aa.get_active())
+            m_generators.add(raster::make_line_generator(raster::wu_line_clipped, x1, y1, x2, y2, clip), 0, 0, 0);
+        if (m_chk_bezier.get_active())
+            m_generators.add(raster::make_bezier_quadratic_generator(x1, y1, cx, cy, x2, y2, clip), 1.0, 0.5, 0.0);
+        if (m_chk_castle.get_active())
+            m_generators.add(raster::make_line_generator(raster::castle_pitteway_line_clipped, x1, y1, x2, y2, clip),
+                             0.0, 1.0, 1.0);
+        if (m_chk_fill.get_active()) {
+            // Круг (центр, радиус) и треугольник (P1, P2, центр) сериями по строкам
+            std::vector<raster::PointD> tri = {{(double)x1, (double)y1}, {(double)x2, (double)y2}, {(double)cx, (double)cy}};
+            m_generators.add(raster::make_fill_circle_generator(cx, cy, r, clip), 0.0, 0.5, 0.5);
+            m_generators.add(raster::make_fill_polygon_generator(std::move(tri), raster::FillRule::NonZero, clip),
+                             0.0, 0.5, 0.5);
+        }
+        if (m_chk_stroke.get_active()) {
+            // Контур обводки строится сразу и заливается сериями по строкам, как многоугольник
+            static const raster::LineJoin joins[] = {raster::LineJoin::Miter, raster::LineJoin::Round, raster::LineJoin::Bevel};
+            static const raster::LineCap caps[] = {raster::LineCap::Butt, raster::LineCap::Round, raster::LineCap::Square};
+            raster::StrokeStyle style;
+            style.width = m_stroke_width.get_value();
+            style.join = joins[std::max(0, m_join_combo.get_active_row_number())];
+            style.cap = caps[std::max(0, m_cap_combo.get_active_row_number())];
+            raster::Polyline lines, outline;
+            lines.points = {{(double)x1, (double)y1}, {(double)cx, (double)cy}, {(double)x2, (double)y2}};
+            lines.starts.push_back(0);
+            lines.closed.push_back(0);
+            raster::stroke_outline(lines, style, outline);
+            m_generators.add(raster::make_fill_polyline_generator(std::move(outline), raster::FillRule::NonZero, clip),
+                             0.55, 0.27, 0.07);
         }
-        intery += gradient;
-    }
-}
 
-// Кривые Безье (Квадратичная)
-void RasterApp::algo_bezier_quadratic(int x1, int y1, int cx, int cy, int x2, int y2) {
-    int steps = std::max(std::abs(x2-x1), std::abs(y2-y1)) + std::max(std::abs(cx-x1), std::abs(cy-y1));
-    if (steps == 0) steps = 1;
-    
-    for (int i = 0; i <= steps; i++) {
-        double t = (double)i / steps;
-        double u = 1 - t;
-        double x = u*u*x1 + 2*u*t*cx + t*t*x2;
-        double y = u*u*y1 + 2*u*t*cy + t*t*y2;
-        
-        queue_pixel_task(std::round(x), std::round(y), 1.0, 0.5, 0.0, 1.0); 
-    }
+        if (!m_generators.empty()) start_playback();
+
+    } catch (...) { std::cerr << "Input Error" << std::endl; }
 }
 
 // --- Cairo Draw ---
 bool RasterApp::on_drawing_area_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
     Gtk::Allocation allocation = m_drawing_area.get_allocation();
-    int w = allocation.get_width();
-    int h = allocation.get_height();
-
-    double scale = (double)m_pixel_scale;
-    double cw = m_canvas_width * scale;
-    double ch = m_canvas_height * scale;
-    double ox = (w - cw)/2.0;
-    double oy = (h - ch)/2.0;
+    if (m_center_pending) { center_view(); m_center_pending = false; }
+
+    double z = m_zoom;
+    int ox, oy;
+    canvas_origin(ox, oy);
+
+    double key[7] = {z, (double)m_canvas_width, (double)m_canvas_height,
+                     (double)allocation.get_width(), (double)allocation.get_height(), (double)ox, (double)oy};
+    if (!m_grid_layer || !std::equal(key, key + 7, m_grid_key)) rebuild_grid_layer();
+
+    // Видимая часть холста: пересечение области перерисовки (queue_draw_area) с холстом
+    const int T = raster::TiledFramebuffer::TILE;
+    double x0, y0, x1, y1;
+    cr->get_clip_extents(x0, y0, x1, y1);
+    int cx0 = std::max(0, (int)std::floor((x0 - ox) / z));
+    int cy0 = std::max(0, (int)std::floor((y0 - oy) / z));
+    int cx1 = std::min(m_canvas_width - 1, (int)std::floor((x1 - ox) / z));
+    int cy1 = std::min(m_canvas_height - 1, (int)std::floor((y1 - oy) / z));
+
+    if (cx0 <= cx1 && cy0 <= cy1) {
+        cr->save();
+        cr->translate(ox, oy);
+        cr->scale(z, z);
+        cr->rectangle(0, 0, m_canvas_width, m_canvas_height);
+        cr->clip();
+
+        // Невыделенные плитки белые: фон один раз, затем только выделенные плитки
+        cr->set_source_rgb(1, 1, 1);
+        cr->rectangle(cx0, cy0, cx1 - cx0 + 1, cy1 - cy0 + 1);
+        cr->fill();
+
+        cr->set_antialias(Cairo::ANTIALIAS_NONE); // без швов между плитками
+        for (int ty = cy0 / T; ty <= cy1 / T; ++ty) {
+            for (int tx = cx0 / T; tx <= cx1 / T; ++tx) {
+                if (!m_canvas.tile(tx, ty)) continue;
+                cr->save();
+                cr->translate(tx * T, ty * T);
+                const Cairo::RefPtr<Cairo::SurfacePattern>& pattern = tile_pattern(tx, ty);
+                pattern->set_filter(z < 1 ? Cairo::FILTER_GOOD : Cairo::FILTER_NEAREST); // при уменьшении усредняем
+                cr->set_source(pattern);
+                cr->rectangle(0, 0, std::min(T, m_canvas_width - tx * T), std::min(T, m_canvas_height - ty * T));
+                cr->fill();
+                cr->restore();
+            }
+        }
+        cr->restore();
+    }
 
-    cr->save();
-    cr->translate(ox, oy);
-    cr->scale(scale, scale);
-    cr->rectangle(0, 0, m_canvas_width, m_canvas_height);
-    cr->clip();
-
-    auto surface = Cairo::ImageSurface::create(&m_pixel_data[0], Cairo::FORMAT_ARGB32, m_canvas_width, m_canvas_height, m_canvas_width*4);
-    auto pattern = Cairo::SurfacePattern::create(surface);
-    pattern->set_filter(Cairo::FILTER_NEAREST);
-    cr->set_source(pattern);
+    cr->set_source(m_grid_layer, 0, 0);
     cr->paint();
 
-    cr->set_source_rgb(0.8, 0.8, 0.8);
-    cr->set_line_width(1.0/scale);
-    for(int i=0; i<=m_canvas_width; ++i) { cr->move_to(i, 0); cr->line_to(i, m_canvas_height); }
-    for(int i=0; i<=m_canvas_height; ++i) { cr->move_to(0, i); cr->line_to(m_canvas_width, i); }
-    cr->stroke();
-    
     if (m_is_real_line_active) {
+        cr->save();
+        cr->translate(ox, oy);
+        cr->scale(z, z);
+        cr->rectangle(0, 0, m_canvas_width, m_canvas_height);
+        cr->clip();
         try {
-            cr->set_source_rgb(0,0,1); cr->set_line_width(0.2);
+            cr->set_source_rgb(0,0,1); cr->set_line_width(std::max(0.2, 1.0 / z));
             cr->move_to(std::stod(m_x1.get_text())+0.5, std::stod(m_y1.get_text())+0.5);
             cr->line_to(std::stod(m_x2.get_text())+0.5, std::stod(m_y2.get_text())+0.5);
             cr->stroke();
         } catch(...) {}
+        cr->restore();
     }
-    cr->restore();
-
-    // Labels
-    cr->save();
-    cr->translate(ox, oy);
-    cr->set_source_rgb(0,0,0);
-    cr->set_font_size(std::max(10.0, scale*0.7));
-    Cairo::TextExtents te;
-    for(int i=0; i<=m_canvas_width; i+=5) {
-        std::string t = std::to_string(i);
-        cr->get_text_extents(t, te);
-        cr->move_to(i*scale - te.width/2, -5);
-        cr->show_text(t);
-    }
-    for(int i=0; i<=m_canvas_height; i+=5) {
-        std::string t = std::to_string(i);
-        cr->get_text_extents(t, te);
-        cr->move_to(-te.width-5, i*scale + te.height/2);
-        cr->show_text(t);
-    }
-    cr->restore();
 
     return true;
 }
@@ -0,0 +1,112 @@
+#ifndef RASTERANIM_HPP
+#define RASTERANIM_HPP
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Планировщик анимации по часам кадров (без зависимостей от GTK):
+ * за кадр проигрывается столько пикселей, сколько положено по целевой скорости,
+ * но не дольше заданной доли периода обновления экрана.
+ */
+namespace raster
+{
+    /**
+     * @brief Статистика проигрывания с последнего start().
+     */
+    struct PlaybackStats
+    {
+        uint64_t frames = 0;          ///< Кадров, в которых что-то проигрывалось.
+        uint64_t dropped_frames = 0;  ///< Пропущенных кадров: интервал между кадрами больше 1.5 периода.
+        uint64_t late_frames = 0;     ///< Кадров, прерванных по времени работы (скорость недостижима).
+        uint64_t pixels = 0;          ///< Проиграно пикселей.
+        int64_t elapsed_us = 0;       ///< От первого кадра до конца последнего.
+        int64_t max_work_us = 0;      ///< Самая долгая работа за кадр.
+
+        /**
+         * @brief Достигнутая скорость, пикселей в секунду.
+         */
+        double achieved_rate() const { return (elapsed_us > 0) ? pixels * 1e6 / elapsed_us : 0; }
+    };
+
+    /**
+     * @brief Выдает бюджет пикселей на кадр по времени кадра (микросекунды часов кадров).
+     * Дробный остаток переходит в следующий кадр, поэтому средняя скорость точна при любой
+     * частоте кадров; команда (серия) проигрывается целиком, а перебор вычитается из следующих
+     * кадров. После паузы (пропущенные кадры, свернутое окно) навёрстывается не больше
+     * MAX_CATCHUP_FRAMES кадров, чтобы анимация не дергалась.
+     */
+    class PlaybackScheduler
+    {
+    public:
+        static constexpr int MAX_CATCHUP_FRAMES = 4;
+
+        /**
+         * @brief Целевая скорость, пикселей в секунду; <= 0 - без ограничения (только время).
+         */
+        void set_rate(double pixels_per_second) { m_rate = pixels_per_second; }
+        double rate() const { return m_rate; }
+
+        /**
+         * @brief Доля периода обновления, которую можно тратить на проигрывание (0.5 по умолчанию).
+         */
+        void set_work_fraction(double fraction) { m_work_fraction = fraction; }
+
+        /**
+         * @brief Сбрасывает отсчет и статистику; следующий кадр считается первым.
+         */
+        void start();
+
+        /**
+         * @brief Проигрывает кадр со временем now_us и периодом обновления refresh_us:
+         * вызывает play() (число пикселей сыгранной команды, 0 - команд больше нет),
+         * пока не исчерпан бюджет пикселей или время работы. Возвращает число пикселей.
+         */
+        template <class Play>
+        uint64_t run_frame(int64_t now_us, int64_t refresh_us, Play&& play);
+
+        const PlaybackStats& stats() const { return m_stats; }
+
+    private:
+        // Бюджет кадра в пикселях (>= 1, если есть кредит)
+        uint64_t begin_frame(int64_t now_us, int64_t refresh_us);
+        void end_frame(uint64_t played, int64_t work_us, bool out_of_time);
+
+        double m_rate = 1000;
+        double m_work_fraction = 0.5;
+        double m_credit = 0;          ///< Пиксели, положенные, но еще не проигранные (< 0 - перебор).
+        int64_t m_first_us = -1;
+        int64_t m_last_us = -1;
+        int64_t m_refresh_us = 16667;
+        PlaybackStats m_stats;
+    };
+
+    template <class Play>
+    uint64_t PlaybackScheduler::run_frame(int64_t now_us, int64_t refresh_us, Play&& play)
+    {
+        using clock = std::chrono::steady_clock;
+        uint64_t budget = begin_frame(now_us, refresh_us);
+        auto start = clock::now();
+        int64_t deadline_us = (int64_t)(m_work_fraction * m_refresh_us);
+
+        uint64_t played = 0;
+        bool out_of_time = false;
+        for (uint32_t calls = 1; played < budget; ++calls) {
+            int n = play();
+            if (n <= 0) break;
+            played += (uint64_t)n;
+            // Часы опрашиваются раз в 64 команды: короткие серии стоят дешевле вызова часов
+            if ((calls & 63) == 0 &&
+                std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count() > deadline_us) {
+                out_of_time = played < budget;
+                break;
+            }
+        }
+        int64_t work_us = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+        end_frame(played, work_us, out_of_time);
+        return played;
+    }
+
+} // namespace raster
+
+#endif // RASTERANIM_HPP
@@ -0,0 +1,101 @@
+#ifndef RASTERBATCH_HPP
+#define RASTERBATCH_HPP
+
+#include "rasterlib.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Пакетная многопоточная отрисовка больших наборов отрезков.
+ */
+namespace raster
+{
+    /**
+     * @brief Пул постоянных потоков с перехватом работы (work stealing).
+     * Каждому потоку выдается свой диапазон индексов; свой диапазон поток берет
+     * с начала, а закончив его, забирает половину остатка с конца чужого.
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * @param threads Число потоков вместе с вызывающим (0 - по числу ядер).
+         */
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned size() const { return m_count; }
+
+        /**
+         * @brief Вызывает fn(index, worker) для index в [0, count) и ждет завершения.
+         * Вызывающий поток работает как поток 0.
+         */
+        void parallel_for(size_t count, const std::function<void(size_t index, unsigned worker)>& fn);
+
+    private:
+        /**
+         * @brief Диапазон [begin, end) в одном слове: begin в старших 32 битах.
+         */
+        struct alignas(64) WorkRange
+        {
+            std::atomic<uint64_t> bounds{0};
+        };
+
+        void worker_loop(unsigned id);
+        void run(unsigned id);
+
+        unsigned m_count = 1;
+        std::unique_ptr<WorkRange[]> m_ranges;
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        uint64_t m_generation = 0;
+        unsigned m_active = 0;
+        bool m_stop = false;
+        const std::function<void(size_t, unsigned)>* m_job = nullptr;
+    };
+
+    /**
+     * @brief Алгоритм пакетной отрисовки.
+     */
+    enum class BatchAlgorithm
+    {
+        Bresenham,
+        Wu
+    };
+
+    /**
+     * @brief Статистика последней пакетной отрисовки.
+     */
+    struct BatchStats
+    {
+        size_t tiles = 0;      ///< Непустых плиток.
+        size_t tile_refs = 0;  ///< Пар (плитка, отрезок).
+    };
+
+    /**
+     * @brief Рисует набор отрезков одним цветом, разбивая холст на плитки tile_size x tile_size.
+     * Отрезки раскладываются по плиткам, которые они пересекают, затем плитки
+     * рисуются параллельно; каждая плитка принадлежит одному потоку, поэтому
+     * запись идет без блокировок. Внутри плитки отрезки рисуются в порядке
+     * индексов, и результат не зависит от числа потоков.
+     * Bresenham записывает цвет без смешивания, Wu смешивает по покрытию (blend_coverage).
+     */
+    BatchStats render_segments(Framebuffer& fb, const Segment* segments, size_t count, Rgba8 color,
+                               BatchAlgorithm algorithm, ThreadPool& pool, int tile_size = 64);
+
+} // namespace raster
+
+#endif // RASTERBATCH_HPP
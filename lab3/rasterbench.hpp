@@ -0,0 +1,96 @@
+#ifndef RASTERBENCH_HPP
+#define RASTERBENCH_HPP
+
+#include "rasterlib.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Воспроизводимые замеры алгоритмов растеризации.
+ */
+namespace raster
+{
+    /**
+     * @brief Набор случайных отрезков длины length со случайным наклоном, целиком внутри холста.
+     * @param seed Зерно генератора: один и тот же набор при одинаковых параметрах.
+     */
+    std::vector<Segment> random_segments(size_t count, int length, int width, int height, uint32_t seed);
+
+    /**
+     * @brief Набор отрезков длины length с наклоном angle_deg градусов к оси X и случайным началом.
+     */
+    std::vector<Segment> sloped_segments(size_t count, int length, double angle_deg, int width, int height, uint32_t seed);
+
+    /**
+     * @brief Сводка по выборке времен (нс).
+     */
+    struct TimingStats
+    {
+        double min_ns = 0;
+        double median_ns = 0;
+        double p99_ns = 0;
+        double mean_ns = 0;
+        size_t samples = 0;
+    };
+
+    TimingStats summarize(std::vector<double> samples_ns);
+
+    /**
+     * @brief Алгоритм в общем виде для замеров.
+     * Для окружности и кривой из отрезка строятся центр/радиус и контрольная точка.
+     */
+    struct BenchAlgorithm
+    {
+        const char* name;
+        void (*draw)(PixelSink& sink, const Segment& s);
+    };
+
+    /**
+     * @brief Все алгоритмы лабораторной в порядке интерфейса.
+     */
+    const std::vector<BenchAlgorithm>& bench_algorithms();
+
+    /**
+     * @brief Результат замера одного алгоритма на одном наборе.
+     * Время в stats - на весь набор отрезков за одно повторение.
+     */
+    struct BenchResult
+    {
+        std::string algorithm;
+        std::string sink;
+        int length = 0;
+        std::optional<double> angle;  ///< Наклон набора в градусах; пусто - случайный (random_segments).
+        size_t segments = 0;
+        uint64_t pixels = 0; ///< Пикселей за одно повторение.
+        TimingStats stats;
+
+        double ns_per_pixel() const { return pixels ? stats.median_ns / pixels : 0; }
+        double lines_per_sec() const { return stats.median_ns > 0 ? segments * 1e9 / stats.median_ns : 0; }
+        double pixels_per_sec() const { return stats.median_ns > 0 ? pixels * 1e9 / stats.median_ns : 0; }
+    };
+
+    /**
+     * @brief Прогревает и замеряет алгоритм на наборе отрезков.
+     * @param prepare Вызывается перед каждым повторением вне замера (например, очистка буфера), может быть пустым.
+     */
+    BenchResult run_benchmark(const BenchAlgorithm& algo, const std::vector<Segment>& segments,
+                              PixelSink& sink, const char* sink_name, int warmup, int repetitions,
+                              void (*prepare)(void* ctx) = nullptr, void* ctx = nullptr);
+
+    /**
+     * @brief Заголовок и строка CSV (случайный наклон - "random" в столбце angle).
+     */
+    std::string csv_header();
+    std::string to_csv(const BenchResult& r);
+
+    /**
+     * @brief Объект JSON для одного результата.
+     */
+    std::string to_json(const BenchResult& r);
+
+} // namespace raster
+
+#endif // RASTERBENCH_HPP
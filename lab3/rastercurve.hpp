@@ -0,0 +1,106 @@
+#ifndef RASTERCURVE_HPP
+#define RASTERCURVE_HPP
+
+#include "rasterlib.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Кривые Безье и контуры: разбиение на ломаные и отрисовка Брезенхемом.
+ */
+namespace raster
+{
+    /**
+     * @brief Точка с дробными координатами (центр пикселя - целые координаты).
+     */
+    struct PointD
+    {
+        double x, y;
+    };
+
+    /**
+     * @brief Контур из отрезков и квадратичных/кубических кривых Безье.
+     * Несколько подконтуров начинаются с move_to; close() замыкает текущий.
+     */
+    class Path
+    {
+    public:
+        enum Verb : uint8_t
+        {
+            MOVE,
+            LINE,
+            QUAD,   ///< Контрольная точка и конец.
+            CUBIC,  ///< Две контрольные точки и конец.
+            CLOSE
+        };
+
+        void move_to(double x, double y);
+        void line_to(double x, double y);
+        void quad_to(double cx, double cy, double x, double y);
+        void cubic_to(double c1x, double c1y, double c2x, double c2y, double x, double y);
+        void close();
+        void clear();
+
+        bool empty() const { return m_verbs.empty(); }
+        const std::vector<Verb>& verbs() const { return m_verbs; }
+        const std::vector<PointD>& points() const { return m_points; }
+
+    private:
+        void ensure_started();
+
+        std::vector<Verb> m_verbs;
+        std::vector<PointD> m_points;
+    };
+
+    /**
+     * @brief Ломаные, полученные из контура: подконтур i занимает точки
+     * [starts[i], starts[i + 1]) (последний - до конца points).
+     */
+    struct Polyline
+    {
+        std::vector<PointD> points;
+        std::vector<uint32_t> starts;
+        std::vector<uint8_t> closed;  ///< 1, если подконтур замкнут.
+
+        void clear() { points.clear(); starts.clear(); closed.clear(); }
+        size_t contours() const { return starts.size(); }
+        uint32_t end(size_t i) const { return (i + 1 < starts.size()) ? starts[i + 1] : (uint32_t)points.size(); }
+    };
+
+    /**
+     * @brief Разбивает контур на ломаные с отклонением от кривых не больше tolerance пикселей.
+     * Число частей кривой берется из оценки второй производной (формула Ванга),
+     * точки считаются прямыми разностями без вычисления полинома.
+     */
+    void flatten_path(const Path& path, double tolerance, Polyline& out);
+
+    /**
+     * @brief Рисует контур линией толщиной в пиксель: ломаные - Брезенхемом,
+     * точки стыков не выдаются дважды, подряд идущие пиксели собираются в серии.
+     * Пиксель, уже выданный одним из 16 предыдущих участков подконтура, монотонных
+     * по обеим осям (кривая дает до 5 таких участков), повторно не выдается.
+     */
+    void draw_path(PixelSink& sink, const Path& path, double tolerance = 0.25);
+
+    /**
+     * @brief Рисует ломаные (с концами в ближайших пикселях) так же, как draw_path.
+     */
+    void draw_polyline(PixelSink& sink, const Polyline& lines);
+
+    /**
+     * @brief draw_path, отсеченный прямоугольником: контур, чьи контрольные точки
+     * лежат вне clip по одну сторону, отбрасывается до разбиения, хорды вне clip
+     * пропускаются, частично видимые рисуются отсеченным Брезенхемом.
+     * Пиксели совпадают с draw_path.
+     */
+    void draw_path_clipped(PixelSink& sink, const Path& path, const ClipRect& clip, double tolerance = 0.25);
+
+    /**
+     * @brief draw_polyline, отсеченный прямоугольником.
+     */
+    void draw_polyline_clipped(PixelSink& sink, const Polyline& lines, const ClipRect& clip);
+
+} // namespace raster
+
+#endif // RASTERCURVE_HPP
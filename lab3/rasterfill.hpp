@@ -0,0 +1,63 @@
+#ifndef RASTERFILL_HPP
+#define RASTERFILL_HPP
+
+#include "rastercurve.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief Заливка многоугольников, контуров, кругов и эллипсов горизонтальными сериями.
+ * Пиксель (x, y) закрашивается, если его центр (x, y) внутри фигуры; на границе
+ * действует правило "левая и верхняя граница включительно", поэтому соседние
+ * фигуры с общей стороной не перекрываются и не оставляют щелей.
+ */
+namespace raster
+{
+    /**
+     * @brief Правило заполнения самопересекающихся контуров.
+     */
+    enum class FillRule
+    {
+        EvenOdd,  ///< Внутри, если луч пересекает контур нечетное число раз.
+        NonZero   ///< Внутри, если число оборотов контура вокруг точки не ноль.
+    };
+
+    /**
+     * @brief Заливает ломаные (каждый подконтур считается замкнутым) внутри clip.
+     * Ребра раскладываются в таблицу по первой строке, строка обходится по списку
+     * активных ребер, отсортированному по x; каждый интервал внутри фигуры
+     * выдается одной горизонтальной серией.
+     * @param antialias Сглаженные края: 16 подстрок на строку, точная площадь по
+     * горизонтали; внутренние пиксели все равно выдаются сериями, краевые - pixel с покрытием.
+     */
+    void fill_polyline(PixelSink& sink, const Polyline& lines, FillRule rule, const ClipRect& clip,
+                       bool antialias = false);
+
+    /**
+     * @brief Заливка многоугольника с вершинами points[0..count).
+     */
+    void fill_polygon(PixelSink& sink, const PointD* points, size_t count, FillRule rule, const ClipRect& clip,
+                      bool antialias = false);
+
+    /**
+     * @brief Заливка контура с кривыми (разбиваются с допуском tolerance, как в draw_path).
+     */
+    void fill_path(PixelSink& sink, const Path& path, FillRule rule, const ClipRect& clip,
+                   bool antialias = false, double tolerance = 0.25);
+
+    /**
+     * @brief Круг, ограниченный окружностью bresenham_circle (граница включительно).
+     * Ширины строк берутся из того же цикла по октанту; каждая строка - одна серия.
+     */
+    void fill_circle(PixelSink& sink, int cx, int cy, int radius, const ClipRect& clip);
+
+    /**
+     * @brief Эллипс с полуосями rx, ry: пиксели с центром внутри или на границе.
+     * Полуширина видимой строки считается напрямую (целый корень), поэтому время
+     * зависит от числа строк внутри clip, а не от размера эллипса; каждая строка - одна серия.
+     */
+    void fill_ellipse(PixelSink& sink, int cx, int cy, int rx, int ry, const ClipRect& clip);
+
+} // namespace raster
+
+#endif // RASTERFILL_HPP
@@ -0,0 +1,124 @@
+#ifndef RASTERGEN_HPP
+#define RASTERGEN_HPP
+
+#include "rasterfill.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Возобновляемые растеризаторы для анимации: примитив выдает пиксели порциями
+ * по запросу, поэтому память при проигрывании пропорциональна числу примитивов, а не пикселей.
+ * Генератор - явный конечный автомат: он хранит только параметры примитива и номер следующей
+ * порции, а порцию рисует отсеченным вариантом алгоритма (*_clipped), который переходит к ней
+ * сразу, без прохода по уже выданным пикселям. Пиксели всех порций вместе - ровно пиксели
+ * отсеченного алгоритма; порции идут от начала примитива к концу, внутри порции - в порядке алгоритма.
+ */
+namespace raster
+{
+    /**
+     * @brief Растеризатор одного примитива, выдающий пиксели порциями.
+     */
+    class PrimitiveGenerator
+    {
+    public:
+        /// Шагов основной оси (или строк заливки) в порции.
+        static constexpr int CHUNK = 64;
+
+        virtual ~PrimitiveGenerator() = default;
+
+        /**
+         * @brief Выдает в sink следующую порцию (она может оказаться пустой, если вся вне clip).
+         * @return false, если примитив уже закончен и ничего не выдано.
+         */
+        virtual bool next(PixelSink& sink) = 0;
+    };
+
+    using LineClippedFn = void (*)(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief Отрезок алгоритмом draw (step_line_clipped, dda_line_clipped, bresenham_line_clipped,
+     * wu_line_clipped, castle_pitteway_line_clipped): порции - полосы по CHUNK столбцов (строк)
+     * основной оси от начала к концу.
+     */
+    std::unique_ptr<PrimitiveGenerator> make_line_generator(LineClippedFn draw, int x1, int y1, int x2, int y2,
+                                                            const ClipRect& clip);
+
+    /**
+     * @brief Окружность Брезенхема: порция - CHUNK шагов x всех восьми октантов;
+     * x, не видимые ни в одном октанте, пропускаются без обхода.
+     */
+    std::unique_ptr<PrimitiveGenerator> make_circle_generator(int cx, int cy, int radius, const ClipRect& clip);
+
+    /**
+     * @brief Ломаные как draw_polyline_clipped: хорды по порядку, длинные - полосами по CHUNK шагов.
+     */
+    std::unique_ptr<PrimitiveGenerator> make_polyline_generator(Polyline lines, const ClipRect& clip);
+
+    /**
+     * @brief Кривые Безье как bezier_quadratic_clipped / bezier_cubic_clipped
+     * (хранятся хорды разбиения, их O(корень из длины)).
+     */
+    std::unique_ptr<PrimitiveGenerator> make_bezier_quadratic_generator(int x1, int y1, int cx, int cy, int x2, int y2,
+                                                                        const ClipRect& clip);
+    std::unique_ptr<PrimitiveGenerator> make_bezier_cubic_generator(int x1, int y1, int c1x, int c1y, int c2x, int c2y,
+                                                                    int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief Круг как fill_circle: строки от центра наружу, CHUNK пар строк за порцию.
+     */
+    std::unique_ptr<PrimitiveGenerator> make_fill_circle_generator(int cx, int cy, int radius, const ClipRect& clip);
+
+    /**
+     * @brief Многоугольник как fill_polygon: полосы по CHUNK строк сверху вниз.
+     */
+    std::unique_ptr<PrimitiveGenerator> make_fill_polygon_generator(std::vector<PointD> points, FillRule rule,
+                                                                    const ClipRect& clip);
+
+    /**
+     * @brief Ломаные как fill_polyline (например, контур stroke_outline): полосы по CHUNK строк.
+     */
+    std::unique_ptr<PrimitiveGenerator> make_fill_polyline_generator(Polyline lines, FillRule rule,
+                                                                     const ClipRect& clip);
+
+    /**
+     * @brief Активные генераторы анимации со своими цветами. Порции берутся по кругу,
+     * поэтому примитивы рисуются одновременно; закончившийся генератор удаляется.
+     */
+    class GeneratorQueue
+    {
+    public:
+        void add(std::unique_ptr<PrimitiveGenerator> generator, double r, double g, double b);
+
+        bool empty() const { return m_active.empty(); }
+        size_t size() const { return m_active.size(); }
+
+        /**
+         * @brief Дописывает в commands порции очередных генераторов (цветом генератора),
+         * пока не появится новая команда или пока генераторы не кончатся.
+         * Пустых порций за вызов не больше MAX_EMPTY_STEPS.
+         * @return false, если генераторов не осталось и новых команд нет, если палитра
+         * commands занята (CommandBuffer::set_color) - тогда надо проиграть накопленные команды -
+         * или если MAX_EMPTY_STEPS порций подряд оказались пустыми (продолжить в следующем кадре).
+         */
+        bool pull(CommandBuffer& commands);
+
+        /// Пустых порций за один pull, после которых управление возвращается планировщику.
+        static constexpr int MAX_EMPTY_STEPS = 256;
+
+        void clear();
+
+    private:
+        struct Entry
+        {
+            std::unique_ptr<PrimitiveGenerator> generator;
+            double r, g, b;
+        };
+        std::vector<Entry> m_active;
+        size_t m_next = 0;
+    };
+
+} // namespace raster
+
+#endif // RASTERGEN_HPP
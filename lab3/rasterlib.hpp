@@ -0,0 +1,511 @@
+#ifndef RASTERLIB_HPP
+#define RASTERLIB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Ядро растеризации без зависимостей от GTK.
+ * Алгоритмы пишут пиксели и серии в приемник (PixelSink): буфер кадра,
+ * буфер команд анимации или счетчик для замеров.
+ */
+namespace raster
+{
+    /**
+     * @brief Цвет RGBA8.
+     */
+    struct Rgba8
+    {
+        uint8_t r, g, b, a;
+    };
+
+    /**
+     * @brief Непрозрачный цвет из компонент [0, 1].
+     */
+    Rgba8 rgba8(double r, double g, double b);
+
+    /**
+     * @brief Направление серии пикселей.
+     */
+    enum SpanKind : uint16_t
+    {
+        SPAN_HORIZONTAL = 0, ///< (x..x+len-1, y)
+        SPAN_VERTICAL = 1    ///< (x, y..y+len-1)
+    };
+
+    /**
+     * @brief Режим смешивания (буфер кадра хранит предумноженный BGRA).
+     */
+    enum class BlendMode
+    {
+        Replace,    ///< dst = lerp(dst, src, покрытие)
+        SourceOver, ///< dst = src + dst * (1 - src.a)
+        Additive,   ///< dst = min(1, src + dst)
+        Multiply    ///< dst = src * dst + src * (1 - dst.a) + dst * (1 - src.a)
+    };
+
+    /**
+     * @brief Приемник результата растеризации.
+     * Цвет задается приемнику заранее; алгоритм сообщает только координаты
+     * и покрытие (0..255).
+     */
+    class PixelSink
+    {
+    public:
+        virtual ~PixelSink() = default;
+
+        /**
+         * @brief Один пиксель с покрытием alpha.
+         */
+        virtual void pixel(int x, int y, uint8_t alpha) = 0;
+
+        /**
+         * @brief Серия из len непрозрачных пикселей. По умолчанию раскладывается на pixel().
+         */
+        virtual void span(SpanKind kind, int x, int y, int len);
+
+        /**
+         * @brief Два соседних пикселя с покрытиями a0 и a1: (x, y) и следующий
+         * по направлению kind (столбец пары сглаженного отрезка).
+         * По умолчанию раскладывается на два pixel().
+         */
+        virtual void pixel_pair(SpanKind kind, int x, int y, uint8_t a0, uint8_t a1);
+    };
+
+    /**
+     * @brief Приемник, который только считает пиксели (для замеров без записи в память).
+     */
+    class CountingSink : public PixelSink
+    {
+    public:
+        void pixel(int, int, uint8_t) override { ++m_pixels; }
+        void span(SpanKind, int, int, int len) override { m_pixels += len; }
+        void pixel_pair(SpanKind, int, int, uint8_t, uint8_t) override { m_pixels += 2; }
+
+        uint64_t pixels() const { return m_pixels; }
+        void reset() { m_pixels = 0; }
+
+    private:
+        uint64_t m_pixels = 0;
+    };
+
+    /**
+     * @brief Буфер кадра BGRA (формат Cairo ARGB32 на little-endian), шаг строки width * 4.
+     */
+    class Framebuffer
+    {
+    public:
+        Framebuffer(int width = 0, int height = 0);
+
+        /**
+         * @brief Меняет размер и заливает белым.
+         */
+        void resize(int width, int height);
+
+        /**
+         * @brief Заливает белым.
+         */
+        void clear();
+
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        int stride() const { return m_width * 4; }
+        uint8_t* data() { return m_data.data(); }
+        const uint8_t* data() const { return m_data.data(); }
+
+        /**
+         * @brief Смешивает цвет с покрытием coverage с пикселем (x, y); точки вне холста отбрасываются.
+         * Целочисленная арифметика над предумноженными каналами.
+         */
+        void blend(int x, int y, Rgba8 color, uint8_t coverage, BlendMode mode = BlendMode::SourceOver);
+
+        /**
+         * @brief Смешивает серию из len пикселей. Серия отсекается по холсту один раз,
+         * горизонтальная смешивается векторно (SSE2/AVX2).
+         */
+        void blend_span(SpanKind kind, int x, int y, int len, Rgba8 color, uint8_t coverage,
+                        BlendMode mode = BlendMode::SourceOver);
+
+        /**
+         * @brief Гамма-корректное смешивание по покрытию: цвета переводятся из sRGB
+         * в линейную яркость по таблицам, смешиваются и переводятся обратно.
+         * Используется для сглаживания: края выглядят одинаково плотными на любом фоне и цвете.
+         */
+        void blend_coverage(int x, int y, Rgba8 color, uint8_t coverage);
+
+        /**
+         * @brief blend_coverage для пары (x, y) и соседнего по kind пикселя.
+         * Горизонтальная пара читается и пишется одним 64-битным словом.
+         */
+        void blend_coverage_pair(SpanKind kind, int x, int y, Rgba8 color, uint8_t c0, uint8_t c1);
+
+    private:
+        int m_width = 0;
+        int m_height = 0;
+        std::vector<uint8_t> m_data;
+    };
+
+    /**
+     * @brief Приемник, рисующий текущим цветом прямо в буфер кадра.
+     * Частичное покрытие в режиме SourceOver смешивается гамма-корректно (blend_coverage).
+     */
+    class FramebufferSink : public PixelSink
+    {
+    public:
+        explicit FramebufferSink(Framebuffer& fb) : m_fb(fb) {}
+
+        void set_color(double r, double g, double b);
+        void set_color(Rgba8 color) { m_color = color; }
+        void set_blend_mode(BlendMode mode) { m_mode = mode; }
+
+        void pixel(int x, int y, uint8_t alpha) override;
+        void span(SpanKind kind, int x, int y, int len) override;
+        void pixel_pair(SpanKind kind, int x, int y, uint8_t a0, uint8_t a1) override;
+
+    private:
+        Framebuffer& m_fb;
+        Rgba8 m_color = {0, 0, 0, 255};
+        BlendMode m_mode = BlendMode::SourceOver;
+    };
+
+    /**
+     * @brief Разреженный буфер кадра из плиток TILE x TILE в формате Framebuffer.
+     * Плитка выделяется при первой записи в нее, невыделенные плитки считаются белыми,
+     * поэтому память пропорциональна закрашенной площади, а не размеру холста
+     * (холст 32768 x 32768 с несколькими линиями занимает единицы мегабайт).
+     * Каждая плитка хранится подряд, шаг ее строки - TILE * 4.
+     */
+    class TiledFramebuffer
+    {
+    public:
+        static constexpr int TILE = 64;
+
+        TiledFramebuffer(int width = 0, int height = 0);
+
+        /**
+         * @brief Меняет размер; все плитки освобождаются.
+         */
+        void resize(int width, int height);
+
+        /**
+         * @brief Заливает белым: плитки помечаются невыделенными, их память
+         * сохраняется для повторного использования.
+         */
+        void clear();
+
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        int tiles_x() const { return m_tiles_x; }
+        int tiles_y() const { return m_tiles_y; }
+        int tile_stride() const { return TILE * 4; }
+
+        /**
+         * @brief Данные плитки (tx, ty) или nullptr, если в нее еще не писали.
+         */
+        uint8_t* tile(int tx, int ty) { return m_tiles[(size_t)ty * m_tiles_x + tx].get(); }
+        const uint8_t* tile(int tx, int ty) const { return m_tiles[(size_t)ty * m_tiles_x + tx].get(); }
+
+        /**
+         * @brief Данные плитки (tx, ty); при первом обращении плитка выделяется и заливается белым.
+         */
+        uint8_t* tile_for_write(int tx, int ty);
+
+        /**
+         * @brief Число выделенных плиток.
+         */
+        size_t allocated_tiles() const { return m_allocated; }
+
+        /**
+         * @brief Меняется при clear() и resize(): указатели на плитки, полученные раньше, недействительны.
+         */
+        uint32_t generation() const { return m_generation; }
+
+        /**
+         * @brief Операции смешивания с теми же правилами, что у Framebuffer.
+         * Серия отсекается по холсту один раз и делится по границам плиток.
+         */
+        void blend(int x, int y, Rgba8 color, uint8_t coverage, BlendMode mode = BlendMode::SourceOver);
+        void blend_span(SpanKind kind, int x, int y, int len, Rgba8 color, uint8_t coverage,
+                        BlendMode mode = BlendMode::SourceOver);
+        void blend_coverage(int x, int y, Rgba8 color, uint8_t coverage);
+        void blend_coverage_pair(SpanKind kind, int x, int y, Rgba8 color, uint8_t c0, uint8_t c1);
+
+    private:
+        uint8_t* pixel_for_write(int x, int y)
+        {
+            return tile_for_write(x / TILE, y / TILE) + ((y % TILE) * TILE + x % TILE) * 4;
+        }
+
+        int m_width = 0;
+        int m_height = 0;
+        int m_tiles_x = 0;
+        int m_tiles_y = 0;
+        size_t m_allocated = 0;
+        uint32_t m_generation = 0;
+        std::vector<std::unique_ptr<uint8_t[]>> m_tiles;
+        std::vector<std::unique_ptr<uint8_t[]>> m_free; ///< Память плиток после clear().
+    };
+
+    /**
+     * @brief Приемник для TiledFramebuffer. Запоминает последнюю плитку, поэтому
+     * соседние точки одной линии пишутся без поиска плитки и проверок границ.
+     */
+    class TiledFramebufferSink : public PixelSink
+    {
+    public:
+        explicit TiledFramebufferSink(TiledFramebuffer& fb) : m_fb(fb) {}
+
+        void set_color(double r, double g, double b);
+        void set_color(Rgba8 color) { m_color = color; }
+        void set_blend_mode(BlendMode mode) { m_mode = mode; }
+
+        void pixel(int x, int y, uint8_t alpha) override;
+        void span(SpanKind kind, int x, int y, int len) override;
+        void pixel_pair(SpanKind kind, int x, int y, uint8_t a0, uint8_t a1) override;
+
+    private:
+        TiledFramebuffer& m_fb;
+        Rgba8 m_color = {0, 0, 0, 255};
+        BlendMode m_mode = BlendMode::SourceOver;
+
+        // Последняя плитка, в которую писал pixel()
+        int m_tile_x = -1, m_tile_y = -1;
+        uint8_t* m_tile = nullptr;
+        uint32_t m_generation = 0;
+    };
+
+    /**
+     * @brief Компактная команда отрисовки (8 байт): точка или горизонтальная/вертикальная серия.
+     */
+    struct DrawCommand
+    {
+        int16_t x;
+        int16_t y;
+        uint16_t run;   ///< Старшие 2 бита - SpanKind, младшие 14 - длина - 1.
+        uint8_t color;  ///< Индекс в палитре.
+        uint8_t alpha;  ///< Покрытие 0..255.
+
+        static constexpr int MAX_LEN = 1 << 14;
+
+        SpanKind kind() const { return (SpanKind)(run >> 14); }
+        int length() const { return (run & (MAX_LEN - 1)) + 1; }
+    };
+
+    /**
+     * @brief Буфер команд отрисовки для пошаговой анимации.
+     * Память не освобождается при очистке, поэтому после первых отрисовок
+     * запись не выделяет память. Соседние точки одного цвета склеиваются
+     * в серии прямо при добавлении.
+     */
+    class CommandBuffer : public PixelSink
+    {
+    public:
+        CommandBuffer() { m_palette.reserve(256); }
+
+        /**
+         * @brief Цвет последующих команд (одинаковые цвета в палитре не дублируются).
+         * Когда в палитре 256 цветов, из нее убираются цвета, на которые не ссылается
+         * ни одна неотыгранная команда.
+         * @return false, если все 256 цветов заняты неотыгранными командами; цвет тогда
+         * не меняется, и новые цвета появятся только после play_front/pop или clear.
+         */
+        bool set_color(double r, double g, double b);
+
+        const Rgba8& color(uint8_t index) const { return m_palette[index]; }
+
+        void pixel(int x, int y, uint8_t alpha) override;
+        void span(SpanKind kind, int x, int y, int len) override;
+
+        bool empty() const { return m_read == m_cmds.size(); }
+        size_t size() const { return m_cmds.size() - m_read; }
+        const DrawCommand& front() const { return m_cmds[m_read]; }
+        void pop() { ++m_read; }
+
+        /**
+         * @brief Проигрывает первую команду целиком в буфер кадра и удаляет ее.
+         * @return Число пикселей команды.
+         */
+        int play_front(Framebuffer& fb, BlendMode mode = BlendMode::SourceOver);
+        int play_front(TiledFramebuffer& fb, BlendMode mode = BlendMode::SourceOver);
+
+        void clear();
+
+    private:
+        bool compact_palette();
+        bool try_extend(int x, int y, uint8_t alpha);
+        void append(SpanKind kind, int x, int y, int len, uint8_t alpha);
+
+        std::vector<DrawCommand> m_cmds;
+        size_t m_read = 0;
+        std::vector<Rgba8> m_palette;
+        uint8_t m_color = 0;
+    };
+
+    /**
+     * @brief Прямоугольник отсечения [x0, x1] x [y0, y1] (границы включительно).
+     */
+    struct ClipRect
+    {
+        int x0, y0, x1, y1;
+
+        bool empty() const { return x0 > x1 || y0 > y1; }
+        bool contains(int x, int y) const { return x >= x0 && x <= x1 && y >= y0 && y <= y1; }
+    };
+
+    /**
+     * @brief Отрезок с целочисленными концами.
+     */
+    struct Segment
+    {
+        int x1, y1, x2, y2;
+    };
+
+    // --- Алгоритмы ---
+
+    /**
+     * @brief Пошаговый алгоритм по уравнению прямой y = kx + b.
+     * Координаты считаются векторно, пиксели выдаются сериями; результат
+     * совпадает с step_line_reference.
+     */
+    void step_line(PixelSink& sink, int x1, int y1, int x2, int y2);
+
+    /**
+     * @brief Скалярный эталон step_line: по одному пикселю за итерацию.
+     */
+    void step_line_reference(PixelSink& sink, int x1, int y1, int x2, int y2);
+
+    /**
+     * @brief step_line, отсеченный прямоугольником: выдает ровно те пиксели step_line,
+     * что попали в clip. Диапазон видимых точек находится сразу (по основной оси - точно,
+     * по второй - двоичным поиском по той же формуле округления), поэтому стоимость
+     * пропорциональна числу видимых пикселей.
+     */
+    void step_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief Цифровой дифференциальный анализатор (ЦДА).
+     * Векторная версия, результат совпадает с dda_line_reference.
+     */
+    void dda_line(PixelSink& sink, int x1, int y1, int x2, int y2);
+
+    /**
+     * @brief Скалярный эталон ЦДА: по одному пикселю за итерацию.
+     */
+    void dda_line_reference(PixelSink& sink, int x1, int y1, int x2, int y2);
+
+    /**
+     * @brief ЦДА, отсеченный прямоугольником, как step_line_clipped. Пиксели совпадают с dda_line.
+     */
+    void dda_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief Целочисленный алгоритм Брезенхема для отрезка.
+     */
+    void bresenham_line(PixelSink& sink, int x1, int y1, int x2, int y2);
+
+    /**
+     * @brief Отрезок Брезенхема, отсеченный прямоугольником.
+     * Выдает ровно те пиксели bresenham_line, что попали в clip: первый видимый
+     * шаг и ошибка на нем вычисляются напрямую, поэтому стоимость пропорциональна
+     * числу видимых пикселей. Пиксели выдаются сериями вдоль основной оси.
+     */
+    void bresenham_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief Окружность Брезенхема; выдает серии по октантам.
+     */
+    void bresenham_circle(PixelSink& sink, int cx, int cy, int radius);
+
+    /**
+     * @brief Окружность Брезенхема, отсеченная прямоугольником: в каждом октанте обходятся
+     * только видимые точки, решающая величина для первой из них считается напрямую.
+     * Пиксели и порядок серий - как у bresenham_circle без невидимых частей.
+     */
+    void bresenham_circle_clipped(PixelSink& sink, int cx, int cy, int radius, const ClipRect& clip);
+
+    /**
+     * @brief Часть bresenham_circle_clipped: точки октантов с x в [x_from, x_to]
+     * (x от 0 до bresenham_circle_octant_end), в том же порядке серий.
+     */
+    void bresenham_circle_clipped(PixelSink& sink, int cx, int cy, int radius, const ClipRect& clip,
+                                  int x_from, int x_to);
+
+    /**
+     * @brief Видимые точки октантов bresenham_circle_clipped: у октанта o это x
+     * в [lo[o], hi[o]] (lo > hi - октант не виден). Считается двоичным поиском, без обхода.
+     */
+    void bresenham_circle_visible_x(int cx, int cy, int radius, const ClipRect& clip, int64_t lo[8], int64_t hi[8]);
+
+    /**
+     * @brief y точки окружности Брезенхема в столбце x первого октанта
+     * (0 <= x <= bresenham_circle_octant_end(radius)) без прохода по предыдущим точкам.
+     */
+    int bresenham_circle_y(int radius, int x);
+
+    /**
+     * @brief Последний x первого октанта окружности Брезенхема (x >= y).
+     */
+    int bresenham_circle_octant_end(int radius);
+
+    /**
+     * @brief Отрезок Кастла-Питвея (построение по цепочке шагов s/d).
+     * Цепочка хранится в сжатом виде (O(log n) памяти, без выделений),
+     * горизонтальные (вертикальные для крутых отрезков) серии выдаются целиком.
+     */
+    void castle_pitteway_line(PixelSink& sink, int x1, int y1, int x2, int y2);
+
+    /**
+     * @brief Отрезок Кастла-Питвея, отсеченный прямоугольником: цепочки узлов, целиком
+     * лежащие до clip, пропускаются без обхода, проход заканчивается на выходе из clip.
+     * Пиксели совпадают с castle_pitteway_line.
+     */
+    void castle_pitteway_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief Сглаженный отрезок, алгоритм Ву.
+     * Целочисленный: шаг 16.16, покрытие 8 бит, столбец из двух пикселей выдается одной парой
+     * (пиксель с нулевым покрытием пропускается). Оба конца - одиночные пиксели с покрытием 128.
+     */
+    void wu_line(PixelSink& sink, int x1, int y1, int x2, int y2);
+
+    /**
+     * @brief Отрезок Ву, отсеченный прямоугольником: перебираются только столбцы,
+     * попадающие в clip по основной оси. Пиксели совпадают с wu_line.
+     */
+    void wu_line_clipped(PixelSink& sink, int x1, int y1, int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief Квадратичная кривая Безье с контрольной точкой (cx, cy).
+     * Разбивается на отрезки с отклонением не больше четверти пикселя (draw_path),
+     * пиксели без пропусков и повторов.
+     */
+    void bezier_quadratic(PixelSink& sink, int x1, int y1, int cx, int cy, int x2, int y2);
+
+    /**
+     * @brief Эталон bezier_quadratic: равномерные шаги t, каждая точка округляется отдельно.
+     */
+    void bezier_quadratic_reference(PixelSink& sink, int x1, int y1, int cx, int cy, int x2, int y2);
+
+    /**
+     * @brief Кубическая кривая Безье с контрольными точками (c1x, c1y) и (c2x, c2y).
+     */
+    void bezier_cubic(PixelSink& sink, int x1, int y1, int c1x, int c1y, int c2x, int c2y, int x2, int y2);
+
+    /**
+     * @brief bezier_quadratic, отсеченная прямоугольником: кривая, чья выпуклая оболочка
+     * (контрольный треугольник) не пересекает clip, отбрасывается сразу, хорды за clip
+     * не растеризуются. Пиксели совпадают с bezier_quadratic.
+     */
+    void bezier_quadratic_clipped(PixelSink& sink, int x1, int y1, int cx, int cy, int x2, int y2, const ClipRect& clip);
+
+    /**
+     * @brief bezier_cubic, отсеченная прямоугольником, как bezier_quadratic_clipped.
+     */
+    void bezier_cubic_clipped(PixelSink& sink, int x1, int y1, int c1x, int c1y, int c2x, int c2y, int x2, int y2,
+                              const ClipRect& clip);
+
+} // namespace raster
+
+#endif // RASTERLIB_HPP
@@ -0,0 +1,138 @@
+#ifndef RASTERSCENE_HPP
+#define RASTERSCENE_HPP
+
+#include "rasterlib.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Сцены из множества примитивов: двоичный формат, который читается отображением
+ * файла в память (mmap) без разбора и выделений на примитив, и текстовый вариант для
+ * ручного написания. Двоичный файл - заголовок SceneHeader и count записей ScenePrimitive
+ * подряд, числа little-endian.
+ *
+ * Текстовый вариант - по команде в строке, '#' - комментарий до конца строки:
+ *   size W H                      размер холста (по умолчанию 1024 x 1024)
+ *   color R G B                   цвет следующих примитивов, 0..255 (по умолчанию черный)
+ *   line X1 Y1 X2 Y2              отрезок (алгоритм выбирается при отрисовке)
+ *   circle CX CY R                окружность Брезенхема
+ *   quad X1 Y1 CX CY X2 Y2        квадратичная кривая Безье
+ *   cubic X1 Y1 C1X C1Y C2X C2Y X2 Y2
+ *   fill_circle CX CY R           круг
+ *   triangle X1 Y1 X2 Y2 X3 Y3    залитый треугольник
+ */
+namespace raster
+{
+    enum class PrimitiveKind : uint8_t
+    {
+        Line = 0,
+        Circle,
+        Quad,
+        Cubic,
+        FillCircle,
+        FillTriangle
+    };
+
+    /**
+     * @brief Примитив сцены (20 байт): вид, цвет и до четырех точек в v[] по порядку
+     * из описания текстового варианта. Неиспользуемые координаты - нули.
+     */
+    struct ScenePrimitive
+    {
+        PrimitiveKind kind;
+        uint8_t r, g, b;
+        int16_t v[8];
+    };
+    static_assert(sizeof(ScenePrimitive) == 20, "ScenePrimitive is stored in files as is");
+
+    /**
+     * @brief Заголовок двоичной сцены (32 байта).
+     */
+    struct SceneHeader
+    {
+        char magic[8];      ///< SCENE_MAGIC.
+        uint32_t version;   ///< SCENE_VERSION.
+        uint32_t width, height;
+        uint32_t reserved;
+        uint64_t count;     ///< Число примитивов после заголовка.
+    };
+    static_assert(sizeof(SceneHeader) == 32, "SceneHeader is stored in files as is");
+
+    extern const char SCENE_MAGIC[8];
+    const uint32_t SCENE_VERSION = 1;
+
+    /**
+     * @brief Загруженная сцена. Двоичный файл остается отображенным в память, пока
+     * существует объект; текстовый разбирается в массив примитивов.
+     */
+    class Scene
+    {
+    public:
+        Scene() = default;
+        ~Scene();
+        Scene(const Scene&) = delete;
+        Scene& operator=(const Scene&) = delete;
+
+        /**
+         * @brief Загружает сцену; формат определяется по сигнатуре.
+         * @return false и описание ошибки в error (если задан), если файл не прочитан.
+         */
+        bool load(const std::string& path, std::string* error = nullptr);
+
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        size_t size() const { return m_count; }
+        const ScenePrimitive* data() const { return m_data; }
+        const ScenePrimitive* begin() const { return m_data; }
+        const ScenePrimitive* end() const { return m_data + m_count; }
+
+        /**
+         * @brief Сцена отображена из двоичного файла (а не разобрана из текста).
+         */
+        bool mapped() const { return m_map != nullptr; }
+
+    private:
+        bool parse_text(const std::string& text, std::string* error);
+        void release();
+
+        void* m_map = nullptr;
+        size_t m_map_size = 0;
+        std::vector<ScenePrimitive> m_parsed;
+        const ScenePrimitive* m_data = nullptr;
+        size_t m_count = 0;
+        int m_width = 0;
+        int m_height = 0;
+    };
+
+    /**
+     * @brief Записывает двоичную сцену.
+     */
+    bool save_scene(const std::string& path, int width, int height, const ScenePrimitive* primitives, size_t count,
+                    std::string* error = nullptr);
+
+    /**
+     * @brief Алгоритм для отрезков сцены.
+     */
+    enum class SceneLineAlgorithm
+    {
+        Step,
+        DDA,
+        Bresenham,
+        Wu,
+        Castle
+    };
+
+    /**
+     * @brief Рисует примитивы сцены по порядку в буфер кадра, отсекая по нему.
+     * Отрезки - выбранным алгоритмом, остальное - как в окне (окружность Брезенхема,
+     * кривые Безье, заливка). Примитивы неизвестного вида пропускаются.
+     */
+    void render_scene(Framebuffer& fb, const Scene& scene, SceneLineAlgorithm algorithm,
+                      BlendMode mode = BlendMode::SourceOver);
+
+} // namespace raster
+
+#endif // RASTERSCENE_HPP
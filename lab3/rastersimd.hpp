@@ -0,0 +1,99 @@
+#ifndef RASTERSIMD_HPP
+#define RASTERSIMD_HPP
+
+#include "rasterlib.hpp"
+
+#include <cstdint>
+
+/**
+ * @brief Векторные ядра растеризации (внутренний заголовок rastercore).
+ * Реализация выбирается при первом вызове по возможностям процессора:
+ * AVX/AVX2, SSE2 или скалярная.
+ */
+namespace raster::simd
+{
+    /**
+     * @brief out[j] = round(base + (first + j) * inc), j = 0..count-1.
+     * Округление - от нуля, как std::round; произведение и сумма считаются
+     * отдельными операциями double, поэтому все реализации дают одинаковый результат.
+     */
+    void round_affine(double base, double inc, int64_t first, int count, int* out);
+
+    /**
+     * @brief Имя выбранной реализации round_affine ("avx", "sse2" или "scalar").
+     */
+    const char* isa_name();
+
+    /**
+     * @brief Округленное x / 255 для x в [0, 255 * 255] умножением и сдвигом.
+     */
+    inline uint32_t div255(uint32_t x) { return ((x + 128) * 257) >> 16; }
+
+    /**
+     * @brief Источник, подготовленный для смешивания: предумноженный цвет BGRA
+     * с учетом покрытия и множитель назначения keep
+     * (Replace: 255 - покрытие, SourceOver: 255 - альфа источника).
+     */
+    struct BlendSource
+    {
+        uint8_t bgra[4];
+        uint8_t keep;
+    };
+
+    inline BlendSource prepare_source(Rgba8 color, uint8_t coverage, BlendMode mode)
+    {
+        uint32_t alpha = div255(color.a * coverage);
+        BlendSource s;
+        s.bgra[0] = (uint8_t)div255(color.b * alpha);
+        s.bgra[1] = (uint8_t)div255(color.g * alpha);
+        s.bgra[2] = (uint8_t)div255(color.r * alpha);
+        s.bgra[3] = (uint8_t)alpha;
+        s.keep = (uint8_t)((mode == BlendMode::Replace) ? 255 - coverage : 255 - alpha);
+        return s;
+    }
+
+    /**
+     * @brief Один пиксель BGRA (предумноженный). Векторные ядра считают то же самое
+     * в тех же округлениях, поэтому результат не зависит от реализации.
+     */
+    inline void blend_one(uint8_t* p, const BlendSource& s, BlendMode mode)
+    {
+        switch (mode) {
+        case BlendMode::Replace:
+        case BlendMode::SourceOver:
+            if (s.keep == 0) { for (int c = 0; c < 4; ++c) p[c] = s.bgra[c]; break; } // непрозрачный источник
+            for (int c = 0; c < 4; ++c) {
+                uint32_t v = s.bgra[c] + div255(p[c] * s.keep);
+                p[c] = (uint8_t)(v > 255 ? 255 : v);
+            }
+            break;
+        case BlendMode::Additive:
+            for (int c = 0; c < 4; ++c) {
+                uint32_t v = s.bgra[c] + p[c];
+                p[c] = (uint8_t)(v > 255 ? 255 : v);
+            }
+            break;
+        case BlendMode::Multiply: {
+            uint32_t da = 255 - p[3], sa = 255 - s.bgra[3];
+            for (int c = 0; c < 4; ++c) {
+                uint32_t v = div255(s.bgra[c] * p[c]) + div255(s.bgra[c] * da) + div255(p[c] * sa);
+                p[c] = (uint8_t)(v > 255 ? 255 : v);
+            }
+            break;
+        }
+        }
+    }
+
+    /**
+     * @brief Смешивает подряд идущие len пикселей BGRA с постоянным источником.
+     */
+    void blend_row(uint8_t* dst, int len, const BlendSource& src, BlendMode mode);
+
+    /**
+     * @brief Имя выбранной реализации blend_row ("avx2", "sse2" или "scalar").
+     */
+    const char* blend_isa_name();
+
+} // namespace raster::simd
+
+#endif // RASTERSIMD_HPP
@@ -0,0 +1,59 @@
+#ifndef RASTERSTROKE_HPP
+#define RASTERSTROKE_HPP
+
+#include "rasterfill.hpp"
+
+/**
+ * @brief Обводка ломаных и контуров линией ширины N: контур обводки строится из
+ * многоугольников (параллелограмм на отрезок, стыки, концы) и заливается одним
+ * проходом fill_polyline по правилу NonZero. Все части обходятся в одном направлении,
+ * поэтому их перекрытия объединяются: каждый пиксель выдается один раз (на стыках нет
+ * повторов), а время растет с числом закрашенных пикселей, а не с шириной, умноженной на длину.
+ */
+namespace raster
+{
+    enum class LineJoin
+    {
+        Miter,  ///< Острый угол; длиннее miter_limit полуширин - как Bevel.
+        Round,  ///< Дуга радиуса width / 2.
+        Bevel   ///< Срез: треугольник между краями соседних отрезков.
+    };
+
+    enum class LineCap
+    {
+        Butt,   ///< Обрыв ровно в конце.
+        Round,  ///< Полукруг радиуса width / 2.
+        Square  ///< Продление на width / 2.
+    };
+
+    struct StrokeStyle
+    {
+        double width = 1;
+        LineJoin join = LineJoin::Miter;
+        LineCap cap = LineCap::Butt;
+        double miter_limit = 4;      ///< Наибольшее отношение длины острия к полуширине (как в SVG).
+        double tolerance = 0.25;     ///< Отклонение хорд дуг от окружности, пикселей.
+    };
+
+    /**
+     * @brief Контур обводки: каждый подконтур out - выпуклый многоугольник одной части
+     * (отрезка, стыка или конца), все с положительной ориентацией. Замкнутые подконтуры
+     * lines получают стык и в первой вершине, незамкнутые - концы.
+     */
+    void stroke_outline(const Polyline& lines, const StrokeStyle& style, Polyline& out);
+
+    /**
+     * @brief Обводка ломаных: stroke_outline, залитый fill_polyline (NonZero) внутри clip.
+     */
+    void stroke_polyline(PixelSink& sink, const Polyline& lines, const StrokeStyle& style, const ClipRect& clip,
+                         bool antialias = false);
+
+    /**
+     * @brief Обводка контура с кривыми (разбиваются с допуском style.tolerance).
+     */
+    void stroke_path(PixelSink& sink, const Path& path, const StrokeStyle& style, const ClipRect& clip,
+                     bool antialias = false);
+
+} // namespace raster
+
+#endif // RASTERSTROKE_HPP
@@ -0,0 +1,175 @@
+#include "rasterbench.hpp"
+#include "rasterscene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef RASTER_HAVE_CAIRO
+#include <cairo.h>
+#endif
+
+// Пакетная отрисовка сцены без окна: загрузка (mmap двоичной сцены или разбор текстовой),
+// отрисовка в буфер кадра и запись PNG через поверхность Cairo; время каждого этапа печатается.
+
+struct Options {
+    std::string scene;
+    std::string output = "scene.png";
+    std::string save_binary;
+    raster::SceneLineAlgorithm algorithm = raster::SceneLineAlgorithm::Bresenham;
+    raster::BlendMode blend = raster::BlendMode::SourceOver;
+    size_t generate = 0;
+    int length = 64;
+    int width = 2048;
+    int height = 2048;
+    uint32_t seed = 42;
+};
+
+static void print_usage() {
+    std::cerr << "Usage: raster_render SCENE [options]\n"
+              << "  -o FILE               PNG (или .ppm) с результатом (scene.png)\n"
+              << "  --algo a              алгоритм отрезков: step,dda,bresenham,wu,castle (bresenham)\n"
+              << "  --blend over|replace|add|multiply  режим смешивания (over)\n"
+              << "  --save-binary FILE    сохранить загруженную сцену в двоичном формате\n"
+              << "  --generate N          сначала записать в SCENE двоичную сцену из N случайных отрезков\n"
+              << "  --length L            длина отрезков для --generate (64)\n"
+              << "  --size WxH            холст для --generate (2048x2048)\n"
+              << "  --seed N              зерно генератора (42)\n";
+}
+
+static bool parse(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (a == "-o") o.output = next();
+            else if (a == "--save-binary") o.save_binary = next();
+            else if (a == "--generate") o.generate = std::stoul(next());
+            else if (a == "--length") o.length = std::stoi(next());
+            else if (a == "--seed") o.seed = (uint32_t)std::stoul(next());
+            else if (a == "--algo") {
+                std::string v = next();
+                if (v == "step") o.algorithm = raster::SceneLineAlgorithm::Step;
+                else if (v == "dda") o.algorithm = raster::SceneLineAlgorithm::DDA;
+                else if (v == "bresenham") o.algorithm = raster::SceneLineAlgorithm::Bresenham;
+                else if (v == "wu") o.algorithm = raster::SceneLineAlgorithm::Wu;
+                else if (v == "castle") o.algorithm = raster::SceneLineAlgorithm::Castle;
+                else { print_usage(); return false; }
+            }
+            else if (a == "--blend") {
+                std::string v = next();
+                if (v == "over") o.blend = raster::BlendMode::SourceOver;
+                else if (v == "replace") o.blend = raster::BlendMode::Replace;
+                else if (v == "add") o.blend = raster::BlendMode::Additive;
+                else if (v == "multiply") o.blend = raster::BlendMode::Multiply;
+                else { print_usage(); return false; }
+            }
+            else if (a == "--size") {
+                std::string v = next();
+                size_t x = v.find('x');
+                o.width = std::stoi(v.substr(0, x));
+                o.height = std::stoi(v.substr(x + 1));
+            }
+            else if (!a.empty() && a[0] != '-' && o.scene.empty()) o.scene = a;
+            else { print_usage(); return false; }
+        } catch (...) { print_usage(); return false; }
+    }
+    if (o.scene.empty()) { print_usage(); return false; }
+    return o.width > 0 && o.width <= 32768 && o.height > 0 && o.height <= 32768;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Случайные отрезки из набора бенчмарка, цвет - из небольшой палитры
+static bool generate_scene(const Options& o, std::string* error) {
+    static const uint8_t palette[][3] = {{0, 0, 255}, {255, 0, 0}, {0, 128, 0}, {128, 0, 128}, {0, 0, 0}};
+    std::vector<raster::Segment> segments = raster::random_segments(o.generate, o.length, o.width, o.height, o.seed);
+    std::vector<raster::ScenePrimitive> primitives(segments.size());
+    std::mt19937 rng(o.seed);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const uint8_t* c = palette[rng() % 5];
+        const raster::Segment& s = segments[i];
+        primitives[i] = {raster::PrimitiveKind::Line, c[0], c[1], c[2],
+                         {(int16_t)s.x1, (int16_t)s.y1, (int16_t)s.x2, (int16_t)s.y2, 0, 0, 0, 0}};
+    }
+    return raster::save_scene(o.scene, o.width, o.height, primitives.data(), primitives.size(), error);
+}
+
+// PPM (P6): предумноженный BGRA поверх непрозрачного белого фона - просто RGB
+static bool write_ppm(const raster::Framebuffer& fb, const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%d %d\n255\n", fb.width(), fb.height());
+    std::vector<uint8_t> row((size_t)fb.width() * 3);
+    bool ok = true;
+    for (int y = 0; y < fb.height() && ok; ++y) {
+        const uint8_t* src = fb.data() + (size_t)y * fb.stride();
+        for (int x = 0; x < fb.width(); ++x) {
+            row[x * 3 + 0] = src[x * 4 + 2];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 0];
+        }
+        ok = std::fwrite(row.data(), 1, row.size(), f) == row.size();
+    }
+    return (std::fclose(f) == 0) && ok;
+}
+
+static bool write_image(raster::Framebuffer& fb, const std::string& path) {
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".ppm") == 0) return write_ppm(fb, path);
+#ifdef RASTER_HAVE_CAIRO
+    // Буфер кадра уже в формате Cairo ARGB32: поверхность создается над ним без копирования
+    cairo_surface_t* surface = cairo_image_surface_create_for_data(fb.data(), CAIRO_FORMAT_ARGB32,
+                                                                   fb.width(), fb.height(), fb.stride());
+    bool ok = cairo_surface_write_to_png(surface, path.c_str()) == CAIRO_STATUS_SUCCESS;
+    cairo_surface_destroy(surface);
+    return ok;
+#else
+    std::cerr << "Built without Cairo: only .ppm output is available" << std::endl;
+    return false;
+#endif
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parse(argc, argv, o)) return 1;
+    std::string error;
+
+    if (o.generate > 0) {
+        auto start = std::chrono::steady_clock::now();
+        if (!generate_scene(o, &error)) { std::cerr << error << std::endl; return 1; }
+        std::cout << "generate: " << ms_since(start) << " ms, " << o.generate << " lines" << std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    raster::Scene scene;
+    if (!scene.load(o.scene, &error)) { std::cerr << error << std::endl; return 1; }
+    std::cout << "load: " << ms_since(start) << " ms, " << scene.size() << " primitives ("
+              << (scene.mapped() ? "binary, mapped" : "text") << "), " << scene.width() << "x" << scene.height() << std::endl;
+
+    if (!o.save_binary.empty()) {
+        if (!raster::save_scene(o.save_binary, scene.width(), scene.height(), scene.data(), scene.size(), &error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    start = std::chrono::steady_clock::now();
+    raster::Framebuffer fb(scene.width(), scene.height());
+    double alloc_ms = ms_since(start);
+    start = std::chrono::steady_clock::now();
+    raster::render_scene(fb, scene, o.algorithm, o.blend);
+    double render_ms = ms_since(start);
+    std::cout << "render: " << render_ms << " ms (+" << alloc_ms << " ms framebuffer), "
+              << (render_ms > 0 ? scene.size() / render_ms * 1e3 : 0) << " primitives/s" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    if (!write_image(fb, o.output)) { std::cerr << "Cannot write " << o.output << std::endl; return 1; }
+    std::cout << "write: " << ms_since(start) << " ms, " << o.output << std::endl;
+    return 0;
+}